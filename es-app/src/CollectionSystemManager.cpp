@@ -390,17 +390,14 @@ void CollectionSystemManager::updateSystemsList()
 	// remove all Collection Systems
 	removeCollectionsFromDisplayedSystems();
 
-	std::unordered_map<std::string, FileData*> map;
-	getAllGamesCollection()->getRootFolder()->createChildrenByFilenameMap(map);
-
 	// add custom enabled ones
-	addEnabledCollectionsToDisplayedSystems(&mCustomCollectionSystemsData, &map);
+	addEnabledCollectionsToDisplayedSystems(&mCustomCollectionSystemsData);
 
 	if (!sortMode.empty() && !sortByManufacturer && !sortByHardware && !sortByReleaseDate && !sortBySubgroup)
 		std::sort(SystemData::sSystemVector.begin(), SystemData::sSystemVector.end(), systemByAlphaSort);
 
 	// add auto enabled ones
-	addEnabledCollectionsToDisplayedSystems(&mAutoCollectionSystemsData, &map);
+	addEnabledCollectionsToDisplayedSystems(&mAutoCollectionSystemsData);
 
 	// Add custom collections bundle to the system list, if there are items
 	if (mCustomCollectionsBundle->getRootFolder()->getChildren().size() > 0)
@@ -493,6 +490,8 @@ void CollectionSystemManager::updateCollectionSystem(FileData* file, const Colle
 			auto newGame = new CollectionFileData(file, curSys);
 			rootFolder->addChild(newGame);
 			curSys->addToIndex(newGame);
+
+			collectionEntry = newGame;
 		}
 	}
 
@@ -504,8 +503,9 @@ void CollectionSystemManager::updateCollectionSystem(FileData* file, const Colle
 		trimCollectionCount(rootFolder, LAST_PLAYED_MAX);
 	}
 	
-	if (view != nullptr)
-		view->onFileChanged(rootFolder, name == "recent" || collectionEntry == nullptr ? FILE_METADATA_CHANGED : FILE_SORTED);
+	// Only the entry of the game changed : the view moves it instead of being populated again
+	if (view != nullptr && collectionEntry != nullptr)
+		view->onFileChanged(collectionEntry, FILE_METADATA_CHANGED);
 }
 
 void CollectionSystemManager::sortLastPlayed(SystemData* system)
@@ -1079,7 +1079,7 @@ void CollectionSystemManager::populateAutoCollection(CollectionSystemData* sysDa
 }
 
 // populates a Custom Collection System
-void CollectionSystemManager::populateCustomCollection(CollectionSystemData* sysData, std::unordered_map<std::string, FileData*>* pMap)
+void CollectionSystemManager::populateCustomCollection(CollectionSystemData* sysData)
 {
 	SystemData* newSys = sysData->system;
 	sysData->isPopulated = true;
@@ -1137,14 +1137,6 @@ void CollectionSystemManager::populateCustomCollection(CollectionSystemData* sys
 
 	FolderData* folder = getAllGamesCollection()->getRootFolder();
 
-	std::unordered_map<std::string, FileData*> map;
-
-	if (pMap == nullptr && folder != nullptr)
-	{
-		folder->createChildrenByFilenameMap(map);
-		pMap = &map;
-	}
-
 	std::string relativeTo = Paths::getRootPath();
 
 	// iterate list of files in config file
@@ -1156,13 +1148,13 @@ void CollectionSystemManager::populateCustomCollection(CollectionSystemData* sys
 		// if item is portable relative to homepath
 		gameKey = Utils::FileSystem::resolveRelativePath(Utils::String::trim(gameKey), relativeTo, true);
 
-		std::unordered_map<std::string, FileData*>::const_iterator it = pMap->find(gameKey);
-		if (it != pMap->cend())
+		FileData* game = folder != nullptr ? folder->FindByPath(gameKey) : nullptr;
+		if (game != nullptr)
 		{
-			if (std::find(hiddenSystems.cbegin(), hiddenSystems.cend(), it->second->getName()) != hiddenSystems.cend())
+			if (std::find(hiddenSystems.cbegin(), hiddenSystems.cend(), game->getName()) != hiddenSystems.cend())
 				continue;
 
-			CollectionFileData* newGame = new CollectionFileData(it->second, newSys);
+			CollectionFileData* newGame = new CollectionFileData(game, newSys);
 			rootFolder->addChild(newGame);
 			newSys->addToIndex(newGame);
 		}
@@ -1202,7 +1194,7 @@ void CollectionSystemManager::removeCollectionsFromDisplayedSystems()
 	ViewController::get()->removeGameListView(mCustomCollectionsBundle);
 }
 
-void CollectionSystemManager::addEnabledCollectionsToDisplayedSystems(std::map<std::string, CollectionSystemData>* colSystemData, std::unordered_map<std::string, FileData*>* pMap)
+void CollectionSystemManager::addEnabledCollectionsToDisplayedSystems(std::map<std::string, CollectionSystemData>* colSystemData)
 {
 	if (Settings::getInstance()->getBool("ThreadedLoading"))
 	{
@@ -1220,9 +1212,9 @@ void CollectionSystemManager::addEnabledCollectionsToDisplayedSystems(std::map<s
 			for (auto collection : collectionsToPopulate)
 			{
 				if (collection->decl.isCustom)
-					pool.queueWorkItem([this, collection, pMap] { populateCustomCollection(collection, pMap); });
+					pool.queueWorkItem([this, collection] { populateCustomCollection(collection); });
 				else
-					pool.queueWorkItem([this, collection, pMap] { populateAutoCollection(collection); });
+					pool.queueWorkItem([this, collection] { populateAutoCollection(collection); });
 			}
 
 			pool.wait();
@@ -1242,7 +1234,7 @@ void CollectionSystemManager::addEnabledCollectionsToDisplayedSystems(std::map<s
 		if (!it->second.isPopulated)
 		{
 			if (it->second.decl.isCustom)
-				populateCustomCollection(&(it->second), pMap);
+				populateCustomCollection(&(it->second));
 			else
 				populateAutoCollection(&(it->second));
 		}
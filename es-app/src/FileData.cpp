@@ -61,8 +61,10 @@ static std::map<std::string, std::function<BindableProperty(FileData*)>> propert
 
 FileData* FileData::mRunningGame = nullptr;
 
+static unsigned int sDisplaySettingsVersion = 0;
+
 FileData::FileData(FileType type, const std::string& path, SystemData* system)
-	: mPath(path), mType(type), mSystem(system), mParent(nullptr), mDisplayName(nullptr), mMetadata(type == GAME ? GAME_METADATA : FOLDER_METADATA) // metadata is REALLY set in the constructor!
+	: mPath(path), mType(type), mSystem(system), mParent(nullptr), mDisplayName(nullptr), mSortKeys(nullptr), mMetadata(type == GAME ? GAME_METADATA : FOLDER_METADATA) // metadata is REALLY set in the constructor!
 {
 	// metadata needs at least a name field (since that's what getName() will return)
 	if (mMetadata.get(MetaDataId::Name).empty() && !mPath.empty())
@@ -134,6 +136,9 @@ FileData::~FileData()
 	if (mDisplayName)
 		delete mDisplayName;
 
+	if (mSortKeys)
+		delete mSortKeys;
+
 	if (mParent)
 		mParent->removeChild(this);
 
@@ -155,6 +160,29 @@ std::string& FileData::getDisplayName()
 	return *mDisplayName;
 }
 
+void FileData::setMetadata(MetaDataList value)
+{
+	// The copied list may have the same version as the current one : values computed from the current one must be outdated
+	unsigned int version = getMetadata().getVersion();
+	getMetadata() = value;
+	getMetadata().mVersion = version + 1;
+}
+
+const FileSorts::SortKeys& FileData::getSortKeys()
+{
+	FileData* source = getSourceFileData();
+	if (source != this)
+		return source->getSortKeys();
+
+	if (mSortKeys == nullptr)
+		mSortKeys = new FileSorts::SortKeys();
+
+	if (!mSortKeys->isUpToDate(this))
+		mSortKeys->update(this);
+
+	return *mSortKeys;
+}
+
 std::string FileData::getCleanName()
 {
 	return Utils::String::removeParenthesis(getDisplayName());
@@ -162,7 +190,7 @@ std::string FileData::getCleanName()
 
 std::string FileData::findLocalArt(const std::string& type, std::vector<std::string> exts)
 {
-	if (Settings::getInstance()->getBool("LocalArt"))
+	if (getSystem() != nullptr && getSystem()->getSettings()->localArt)
 	{
 		for (auto ext : exts)
 		{
@@ -313,7 +341,8 @@ std::vector<std::string> FileData::getFileMedias()
 
 void FileData::resetSettings() 
 {
-	
+	// Display settings changed : lists cached by FolderData::getChildrenListToDisplay are outdated
+	sDisplaySettingsVersion++;
 }
 
 const std::string& FileData::getName()
@@ -1001,17 +1030,14 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 {
 	std::vector<FileData*> ret;
 
+	auto settings = getSystem()->getSettings();
+
 	std::string showFoldersMode = getSystem()->getFolderViewMode();
 	
-	bool showHiddenFiles = Settings::ShowHiddenFiles();
-
-	auto shv = Settings::getInstance()->getString(getSystem()->getName() + ".ShowHiddenFiles");
-	if (shv == "1") showHiddenFiles = true;
-	else if (shv == "0") showHiddenFiles = false;
-
+	bool showHiddenFiles = settings->showHiddenFiles;
 	bool filterKidGame = false;
 
-	if (!Settings::getInstance()->getBool("ForceDisableFilters"))
+	if (!settings->forceDisableFilters)
 	{
 		if (UIModeController::getInstance()->isUIModeKiosk())
 			showHiddenFiles = false;
@@ -1022,9 +1048,7 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 
 	auto sys = CollectionSystemManager::get()->getSystemToView(mSystem);
 
-	std::vector<std::string> hiddenExts;
-	if (mSystem->isGameSystem() && !mSystem->isCollection())
-		hiddenExts = Utils::String::split(Utils::String::toLower(Settings::getInstance()->getString(mSystem->getName() + ".HiddenExt")), ';');
+	const std::set<std::string>& hiddenExts = settings->hiddenExtensions;
 
 	FileFilterIndex* idx = sys->getIndex(false);
 	if (idx != nullptr && !idx->isFiltered())
@@ -1039,33 +1063,118 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 		items = &flatGameList;		
 	}
 
-	std::map<FileData*, int> scoringBoard;
+	unsigned int currentSortId = sys->getSortId();
+	if (currentSortId > FileSorts::getSortTypes().size())
+		currentSortId = 0;
 
+	bool foldersFirst = Settings::ShowFoldersFirst();
+	bool favoritesFirst = settings->showFavoritesFirst;
 	bool refactorUniqueGameFolders = (showFoldersMode == "having multiple games");
 
-	for (auto it = items->cbegin(); it != items->cend(); it++)
+	// A list is reused while its items and their metadata are the same. Folders replaced by their unique game or shown
+	// according to their filtered games depend on the games inside them : these lists are built each time.
+	bool useCache = true;
+	if (refactorUniqueGameFolders || idx != nullptr)
 	{
-		if (!showHiddenFiles && (*it)->getHidden())
-			continue;
+		for (auto item : *items)
+		{
+			if (item->getType() == FOLDER)
+			{
+				useCache = false;
+				break;
+			}
+		}
+	}
 
-		if (filterKidGame && (*it)->getType() == GAME && !(*it)->getKidGame())
-			continue;
+	const FileSorts::SortType& sort = FileSorts::getSortTypes().at(currentSortId);
+	auto compf = sort.comparisonFunction;
+	bool ascending = sort.ascending;
+	bool sortByRelevancy = (idx != nullptr && idx->hasRelevency());
+
+	auto compareItems = [compf, ascending, foldersFirst, favoritesFirst](const FileData* file1, const FileData* file2) -> bool
+	{
+		if (favoritesFirst && file1->getFavorite() != file2->getFavorite())
+			return file1->getFavorite();
 
-		if (hiddenExts.size() > 0 && (*it)->getType() == GAME)
+		if (foldersFirst && file1->getType() != file2->getType())
+			return (file1->getType() == FOLDER);
+
+		return compf(file1, file2) == ascending;
+	};
+
+	// 0 if the file is not displayed, else its score in the filters
+	auto getDisplayScore = [showHiddenFiles, filterKidGame, &hiddenExts, idx](FileData* file) -> int
+	{
+		if (!showHiddenFiles && file->getHidden())
+			return 0;
+
+		if (filterKidGame && file->getType() == GAME && !file->getKidGame())
+			return 0;
+
+		if (hiddenExts.size() > 0 && file->getType() == GAME)
 		{
-			std::string extlow = Utils::String::toLower(Utils::FileSystem::getExtension((*it)->getFileName(), false));
-			if (std::find(hiddenExts.cbegin(), hiddenExts.cend(), extlow) != hiddenExts.cend())
-				continue;
+			std::string extlow = Utils::String::toLower(Utils::FileSystem::getExtension(file->getFileName(), false));
+			if (hiddenExts.find(extlow) != hiddenExts.cend())
+				return 0;
 		}
 
 		if (idx != nullptr)
+			return idx->showFile(file);
+
+		return 1;
+	};
+
+	DisplayList* cache = nullptr;
+	if (useCache)
+	{
+		std::string signature = std::to_string(currentSortId) + "|" + std::to_string(sDisplaySettingsVersion) + "|" + sys->getName() + "|" + showFoldersMode + "|" +
+			(showHiddenFiles ? "H" : "") + (filterKidGame ? "K" : "") + (foldersFirst ? "F" : "") + (favoritesFirst ? "S" : "") + (Settings::IgnoreLeadingArticles() ? "A" : "") + "|" +
+			std::to_string(settings->version) + "|" + (idx == nullptr ? "" : idx->getFilterSignature());
+
+		if (mDisplayLists == nullptr)
+			mDisplayLists = new std::unordered_map<std::string, DisplayList>();
+
+		auto it = mDisplayLists->find(signature);
+		if (it != mDisplayLists->cend())
 		{
-			int score = idx->showFile(*it);
-			if (score == 0)
-				continue;
+			DisplayList& list = it->second;
 
-			scoringBoard[*it] = score;
+			int changed = list.findChangedSource(*items, mContentVersion);
+			if (changed == DisplayList::UP_TO_DATE)
+				return list.items;
+
+			// A single game changed : move it to its sorted place instead of filtering & sorting every item again
+			if (changed >= 0 && (*items)[changed]->getType() == GAME && !sortByRelevancy)
+			{
+				FileData* file = (*items)[changed];
+
+				auto pos = std::find(list.items.begin(), list.items.end(), file);
+				if (pos != list.items.end())
+					list.items.erase(pos);
+
+				if (getDisplayScore(file) != 0)
+					list.items.insert(std::upper_bound(list.items.begin(), list.items.end(), file, compareItems), file);
+
+				list.sources[changed].second = file->getMetadata().getVersion();
+				return list.items;
+			}
 		}
+		else if (mDisplayLists->size() >= MAX_DISPLAY_LISTS)
+			mDisplayLists->clear();
+
+		cache = &(*mDisplayLists)[signature];
+	}
+
+	std::map<FileData*, int> scoringBoard;
+
+	for (auto it = items->cbegin(); it != items->cend(); it++)
+	{
+		int score = getDisplayScore(*it);
+		if (score == 0)
+			continue;
+
+		if (idx != nullptr)
+			scoringBoard[*it] = score;
 
 		if ((*it)->getType() == FOLDER && refactorUniqueGameFolders)
 		{
@@ -1100,17 +1209,9 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 		ret.push_back(*it);
 	}
 
-	unsigned int currentSortId = sys->getSortId();
-	if (currentSortId > FileSorts::getSortTypes().size())
-		currentSortId = 0;
-
-	const FileSorts::SortType& sort = FileSorts::getSortTypes().at(currentSortId);
-
-	if (idx != nullptr && idx->hasRelevency())
+	if (sortByRelevancy)
 	{
-		auto compf = sort.comparisonFunction;
-
-		std::sort(ret.begin(), ret.end(), [scoringBoard, compf](const FileData* file1, const FileData* file2) -> bool
+		std::sort(ret.begin(), ret.end(), [&scoringBoard, compf](const FileData* file1, const FileData* file2) -> bool
 		{ 
 			auto s1 = scoringBoard.find((FileData*) file1);
 			auto s2 = scoringBoard.find((FileData*) file2);		
@@ -1123,19 +1224,43 @@ const std::vector<FileData*> FolderData::getChildrenListToDisplay()
 	}
 	else
 	{
-		bool foldersFirst = Settings::ShowFoldersFirst();
-		bool favoritesFirst = getSystem()->getShowFavoritesFirst();
+		std::stable_sort(ret.begin(), ret.end(), compareItems);
+	}
 
-		std::stable_sort(ret.begin(), ret.end(), [sort, foldersFirst, favoritesFirst](const FileData* file1, const FileData* file2) -> bool
-			{
-				if (favoritesFirst && file1->getFavorite() != file2->getFavorite())
-					return file1->getFavorite();
+	if (cache != nullptr)
+	{
+		cache->contentVersion = mContentVersion;
+		cache->sources.clear();
+		cache->sources.reserve(items->size());
 
-				if (foldersFirst && file1->getType() != file2->getType())
-					return (file1->getType() == FOLDER);
+		for (auto item : *items)
+			cache->sources.push_back(std::make_pair(item, item->getMetadata().getVersion()));
 
-				return sort.comparisonFunction(file1, file2) == sort.ascending;
-			});
+		cache->items = ret;
+	}
+
+	return ret;
+}
+
+int FolderData::DisplayList::findChangedSource(const std::vector<FileData*>& files, unsigned int folderContentVersion) const
+{
+	if (contentVersion != folderContentVersion || sources.size() != files.size())
+		return OUTDATED;
+
+	int ret = UP_TO_DATE;
+
+	for (size_t i = 0; i < files.size(); i++)
+	{
+		if (sources[i].first != files[i])
+			return OUTDATED;
+
+		if (sources[i].second != files[i]->getMetadata().getVersion())
+		{
+			if (ret != UP_TO_DATE)
+				return OUTDATED;
+
+			ret = (int)i;
+		}
 	}
 
 	return ret;
@@ -1175,20 +1300,14 @@ FileData* FolderData::findUniqueGameForFolder()
 
 	FileData* found = nullptr;
 
+	auto settings = getSystem()->getSettings();
+	bool showHiddenFiles = settings->showHiddenFiles && (settings->showHiddenFilesOverriden || !UIModeController::getInstance()->isUIModeKiosk());
+
 	int count = 0;
 	for (auto game : games)
 	{
-		if (game->getHidden())
-		{
-			bool showHiddenFiles = Settings::ShowHiddenFiles() && !UIModeController::getInstance()->isUIModeKiosk();
-
-			auto shv = Settings::getInstance()->getString(getSystem()->getName() + ".ShowHiddenFiles");
-			if (shv == "1") showHiddenFiles = true;
-			else if (shv == "0") showHiddenFiles = false;
-
-			if (!showHiddenFiles)
-				continue;
-		}
+		if (game->getHidden() && !showHiddenFiles)
+			continue;
 
 		found = game;
 		count++;
@@ -1241,10 +1360,10 @@ void FolderData::getFilesRecursiveWithContext(std::vector<FileData*>& out, unsig
 					if (filter->filterKidGame && it->getKidGame())
 						continue;
 
-					if (typeMask == GAME && filter->hiddenExtensions.size() > 0)
+					if (typeMask == GAME && filter->hiddenExtensions->size() > 0)
 					{
 						std::string extlow = Utils::String::toLower(Utils::FileSystem::getExtension(it->getFileName(), false));
-						if (filter->hiddenExtensions.find(extlow) != filter->hiddenExtensions.cend())
+						if (filter->hiddenExtensions->find(extlow) != filter->hiddenExtensions->cend())
 							continue;
 					}
 				}
@@ -1280,22 +1399,12 @@ std::vector<FileData*> FolderData::getFilesRecursive(unsigned int typeMask, bool
 {
 	SystemData* pSystem = (system != nullptr ? system : mSystem);
 	
-	GetFileContext ctx;
-	ctx.showHiddenFiles = Settings::ShowHiddenFiles() && !UIModeController::getInstance()->isUIModeKiosk();
-
-	auto shv = Settings::getInstance()->getString(getSystem()->getName() + ".ShowHiddenFiles");
-	if (shv == "1")
-		ctx.showHiddenFiles = true;
-	else if (shv == "0")
-		ctx.showHiddenFiles = false;
-
-	if (pSystem->isGameSystem() && !pSystem->isCollection())
-	{
-		for (auto ext : Utils::String::split(Utils::String::toLower(Settings::getInstance()->getString(pSystem->getName() + ".HiddenExt")), ';'))
-			if (ctx.hiddenExtensions.find(ext) == ctx.hiddenExtensions.cend())
-				ctx.hiddenExtensions.insert(ext);
-	}
+	auto settings = getSystem()->getSettings();
+	auto systemSettings = (pSystem == getSystem() ? settings : pSystem->getSettings());
 
+	GetFileContext ctx;
+	ctx.showHiddenFiles = settings->showHiddenFiles && (settings->showHiddenFilesOverriden || !UIModeController::getInstance()->isUIModeKiosk());
+	ctx.hiddenExtensions = &systemSettings->hiddenExtensions;
 	ctx.filterKidGame = UIModeController::getInstance()->isUIModeKid();
 
 	std::vector<FileData*> out;
@@ -1312,7 +1421,12 @@ void FolderData::addChild(FileData* file, bool assignParent)
 	mChildren.push_back(file);
 
 	if (assignParent)
-		file->setParent(this);	
+	{
+		file->setParent(this);
+		mSystem->addToPathIndex(file);
+	}
+
+	onContentChanged();
 }
 
 void FolderData::removeChild(FileData* file)
@@ -1325,9 +1439,13 @@ void FolderData::removeChild(FileData* file)
 	auto it = std::find(mChildren.begin(), mChildren.end(), file);
 	if (it != mChildren.end())
 	{
+		if (file->getParent() == this)
+			mSystem->removeFromPathIndex(file);
+
 		file->setParent(nullptr);
 		std::iter_swap(it, mChildren.end() - 1);
 		mChildren.pop_back();
+		onContentChanged();
 	}
 
 	// File somehow wasn't in our children.
@@ -1342,10 +1460,13 @@ void FolderData::bulkRemoveChildren(std::vector<FileData*>& mChildren, const std
 		std::remove_if(
 			mChildren.begin(),
 			mChildren.end(),
-			[&filesToRemove](FileData* file)
+			[this, &filesToRemove](FileData* file)
 			{
 				if (filesToRemove.count(file))
 				{
+					if (file->getParent() == this)
+						mSystem->removeFromPathIndex(file);
+
 					file->setParent(nullptr);
 					return true;
 				}
@@ -1354,11 +1475,16 @@ void FolderData::bulkRemoveChildren(std::vector<FileData*>& mChildren, const std
 		),
 		mChildren.end()
 	);
+
+	onContentChanged();
 }
 
 FileData* FolderData::FindByPath(const std::string& path)
 {
-	std::vector<FileData*> children = getChildren();
+	if (mOwnsChildrens && mSystem->isPathIndexComplete())
+		return mSystem->findInPathIndex(path, this);
+
+	const std::vector<FileData*>& children = getChildren();
 
 	for (std::vector<FileData*>::const_iterator it = children.cbegin(); it != children.cend(); ++it)
 	{
@@ -1376,19 +1502,6 @@ FileData* FolderData::FindByPath(const std::string& path)
 	return nullptr;
 }
 
-void FolderData::createChildrenByFilenameMap(std::unordered_map<std::string, FileData*>& map)
-{
-	std::vector<FileData*> children = getChildren();
-
-	for (std::vector<FileData*>::const_iterator it = children.cbegin(); it != children.cend(); ++it)
-	{
-		if ((*it)->getType() == FOLDER)
-			((FolderData*)(*it))->createChildrenByFilenameMap(map);			
-		else 
-			map[(*it)->getKey()] = (*it);
-	}	
-}
-
 const std::string FileData::getCore(bool resolveDefault)
 {
 #if WIN32 && !_DEBUG
@@ -1749,21 +1862,42 @@ FolderData::FolderData(const std::string& startpath, SystemData* system, bool ow
 {
 	mIsDisplayableAsVirtualFolder = false;
 	mOwnsChildrens = ownsChildrens;
+	mContentVersion = 0;
+	mDisplayLists = nullptr;
 }
 
 FolderData::~FolderData()
 {
 	clear();
+
+	if (mDisplayLists != nullptr)
+		delete mDisplayLists;
+}
+
+void FolderData::onContentChanged()
+{
+	for (FolderData* folder = this; folder != nullptr; folder = folder->getParent())
+		folder->mContentVersion++;
 }
 
 void FolderData::clear() {
 	if (mOwnsChildrens)
+	{
+		// the whole tree of the system is deleted : its path index is emptied at once instead of file by file
+		if (mSystem->getRootFolder() == this)
+			mSystem->clearPathIndex();
+
 		for (auto* child : mChildren)
 		{
+			if (child->getParent() == this)
+				mSystem->removeFromPathIndex(child);
+
 			child->setParent(nullptr); // prevent each child from inefficiently removing itself from our mChildren vector, since we're about to clear it anyway
 			delete child;
 		}
+	}
 	mChildren.clear();
+	onContentChanged();
 }
 
 void FolderData::removeFromVirtualFolders(FileData* game)
@@ -1779,6 +1913,7 @@ void FolderData::removeFromVirtualFolders(FileData* game)
 		if ((*it) == game)
 		{
 			mChildren.erase(it);
+			onContentChanged();
 			return;
 		}
 	}
@@ -17,6 +17,8 @@
 class Window;
 struct SystemEnvironmentData;
 
+namespace FileSorts { struct SortKeys; }
+
 
 enum FileType
 {
@@ -45,7 +47,7 @@ struct GetFileContext
 {
 	bool showHiddenFiles;
 	bool filterKidGame;
-	std::set<std::string> hiddenExtensions;
+	const std::set<std::string>* hiddenExtensions;
 };
 
 struct LaunchGameOptions
@@ -148,7 +150,7 @@ public:
 	virtual const MetaDataList& getMetadata() const { return mMetadata; }
 	virtual MetaDataList& getMetadata() { return mMetadata; }
 
-	void setMetadata(MetaDataList value) { getMetadata() = value; } 
+	void setMetadata(MetaDataList value);
 	
 	std::string getMetadata(MetaDataId key) const { return getMetadata().get(key); }
 	void setMetadata(MetaDataId key, const std::string& value) { return getMetadata().set(key, value); }
@@ -186,6 +188,9 @@ public:
 
 	std::string getGenre();
 
+	// Values compared by the FileSorts comparators, computed again when the metadata changes
+	const FileSorts::SortKeys& getSortKeys();
+
 private:
 	std::string getKeyboardMappingFilePath();
 	std::string getMessageFromExitCode(int exitCode);
@@ -201,6 +206,7 @@ protected:
 	FileType mType;
 	SystemData* mSystem;
 	std::string* mDisplayName;
+	FileSorts::SortKeys* mSortKeys;
 };
 
 class CollectionFileData : public FileData
@@ -253,8 +259,6 @@ public:
 	void removeChild(FileData* file); //Error if mType != FOLDER
 	void bulkRemoveChildren(std::vector<FileData*>& mChildren, const std::unordered_set<FileData*>& filesToRemove); //Error if mType != FOLDER
 
-	void createChildrenByFilenameMap(std::unordered_map<std::string, FileData*>& map);
-
 	FileData* findUniqueGameForFolder();
 
 	void clear();
@@ -264,10 +268,31 @@ public:
 private:
 	void getFilesRecursiveWithContext(std::vector<FileData*>& out, unsigned int typeMask, GetFileContext* filter, bool displayedOnly, SystemData* system, bool includeVirtualStorage) const;
 
+	// Files were added or removed in this folder or below
+	void onContentChanged();
+
+	// A list returned by getChildrenListToDisplay, with what it was built from
+	struct DisplayList
+	{
+		static const int UP_TO_DATE = -1;
+		static const int OUTDATED = -2;
+
+		// UP_TO_DATE, OUTDATED, or the index of the only file whose metadata changed : the list can be patched
+		int findChangedSource(const std::vector<FileData*>& files, unsigned int folderContentVersion) const;
+
+		unsigned int contentVersion;
+		std::vector<std::pair<FileData*, unsigned int>> sources; // files & version of their metadata
+		std::vector<FileData*> items;
+	};
+
+	static const size_t MAX_DISPLAY_LISTS = 8;
 
 	std::vector<FileData*> mChildren;
 	bool	mOwnsChildrens;
 	bool	mIsDisplayableAsVirtualFolder;
+
+	unsigned int mContentVersion;
+	std::unordered_map<std::string, DisplayList>* mDisplayLists; // by sort, filters & display settings
 };
 
 #endif // ES_APP_FILE_DATA_H
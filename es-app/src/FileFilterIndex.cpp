@@ -8,6 +8,7 @@
 #include "LocaleES.h"
 
 #include <pugixml/src/pugixml.hpp>
+#include <algorithm>
 
 #include "SystemData.h"
 #include "FileData.h"
@@ -21,6 +22,7 @@
 FileFilterIndex::FileFilterIndex()
 	: filterByFavorites(false), filterByGenre(false), filterByKidGame(false), filterByPlayers(false), filterByPubDev(false), filterByRatings(false), filterByYear(false)
 	, filterByLightGun(false), filterByWheel(false), filterByTrackball(false), filterBySpinner(false), filterByVertical(false), filterByCheevos(false), filterByPlayed(false), filterByRegion(false), filterByLang(false), filterByFamily(false), filterByHasMedia(false), filterByMissingMedia(false)
+	, mTextScoresValid(false), mSelectedBitmapsValid(false), mSelectedBitmapsLayout(0), mShownGamesVersion(0)
 {
 	clearAllFilters();
 	FilterDataDecl filterDecls[] = 
@@ -92,6 +94,8 @@ void FileFilterIndex::copyFrom(FileFilterIndex* indexToImport)
 
 		*src->second.filteredByRef = *decl.second.filteredByRef;
 	}
+
+	onFiltersChanged();
 }
 
 void FileFilterIndex::importIndex(FileFilterIndex* indexToImport)
@@ -149,6 +153,13 @@ void FileFilterIndex::resetIndex()
 	mTextFilter = "";
 	clearAllFilters();
 
+	mSearchIndex.clear();
+	mTextScores.clear();
+	mTextScoresValid = false;
+
+	mBitmaps.clear();
+	onFiltersChanged();
+
 	clearIndex(genreIndexAllKeys);
 	clearIndex(familyIndexAllKeys);
 	clearIndex(playersIndexAllKeys);
@@ -439,6 +450,11 @@ void FileFilterIndex::addToIndex(FileData* game)
 {
 	game->detectLanguageAndRegion(false);
 
+	mSearchIndex.add(game);
+	mTextScoresValid = false;
+
+	mBitmaps.add(game);
+
 	manageGenreEntryInIndex(game);
 	manageFamilyEntryInIndex(game);
 	managePlayerEntryInIndex(game);
@@ -450,6 +466,11 @@ void FileFilterIndex::addToIndex(FileData* game)
 
 void FileFilterIndex::removeFromIndex(FileData* game)
 {
+	mSearchIndex.remove(game);
+	mTextScoresValid = false;
+
+	mBitmaps.remove(game);
+
 	manageGenreEntryInIndex(game, true);
 	manageFamilyEntryInIndex(game, true);
 	managePlayerEntryInIndex(game, true);
@@ -475,6 +496,7 @@ void FileFilterIndex::setFilter(FilterIndexType type, std::vector<std::string>*
 	FilterDataDecl& filterData = it->second;
 	*(filterData.filteredByRef) = values != nullptr && values->size() > 0;
 	filterData.currentFilteredKeys->clear();
+	onFiltersChanged();
 
 	if (values == nullptr)
 		return;
@@ -509,7 +531,8 @@ void FileFilterIndex::clearAllFilters()
 		*(filterData.filteredByRef) = false;
 		filterData.currentFilteredKeys->clear();
 	}
-	return;
+
+	onFiltersChanged();
 }
 
 void FileFilterIndex::resetFilters()
@@ -535,94 +558,57 @@ void FileFilterIndex::setTextFilter(const std::string text, bool useRelevancy)
 { 
 	mTextFilter = text;
 	mUseRelevency = useRelevancy;
+	onFiltersChanged();
 }
 
-float jw_distance(std::string s1, std::string s2, bool caseSensitive = true) {
-	float m = 0;
-	int low, high, range;
-	int k = 0, numTrans = 0;
+std::string FileFilterIndex::getFilterSignature()
+{
+	std::string ret = (mUseRelevency ? "relevancy:" : "text:") + mTextFilter;
 
-	// Exit early if either are empty
-	if (s1.length() == 0 || s2.length() == 0) {
-		return 0;
-	}
+	for (auto& it : mFilterDecl)
+	{
+		FilterDataDecl& filterData = it.second;
+		if (!*(filterData.filteredByRef))
+			continue;
 
-	// Convert to lower if case-sensitive is false
-	if (caseSensitive == false) {
-		transform(s1.begin(), s1.end(), s1.begin(), ::tolower);
-		transform(s2.begin(), s2.end(), s2.begin(), ::tolower);
-	}
+		std::vector<std::string> keys(filterData.currentFilteredKeys->cbegin(), filterData.currentFilteredKeys->cend());
+		std::sort(keys.begin(), keys.end());
 
-	// Exit early if they're an exact match.
-	if (s1 == s2) {
-		return 1;
+		ret += "\n" + std::to_string(it.first) + ":" + Utils::String::join(keys, "\t");
 	}
 
-	range = (std::max(s1.length(), s2.length()) / 2) - 1;
-	int s1Matches[65000] = {};
-	int s2Matches[65000] = {};
-
-	for (int i = 0; i < s1.length(); i++) {
-
-		// Low Value;
-		if (i >= range) {
-			low = i - range;
-		}
-		else {
-			low = 0;
-		}
-
-		// High Value;
-		if (i + range <= (s2.length() - 1)) {
-			high = i + range;
-		}
-		else {
-			high = s2.length() - 1;
-		}
-
-		for (int j = low; j <= high; j++) {
-			if (s1Matches[i] != 1 && s2Matches[j] != 1 && s1[i] == s2[j]) {
-				m += 1;
-				s1Matches[i] = 1;
-				s2Matches[j] = 1;
-				break;
-			}
-		}
-	}
+	return ret;
+}
 
-	// Exit early if no matches were found
-	if (m == 0) {
-		return 0;
+int FileFilterIndex::getTextScore(FileData* game)
+{
+	// The name of a game can change without the game being indexed again (scraper import...)
+	if (!mSearchIndex.isUpToDate(game))
+	{
+		mSearchIndex.update(game);
+		mTextScoresValid = false;
 	}
 
-	// Count the transpositions.
-	for (int i = 0; i < s1.length(); i++) {
-		if (s1Matches[i] == 1) {
-			int j;
-			for (j = k; j < s2.length(); j++) {
-				if (s2Matches[j] == 1) {
-					k = j + 1;
-					break;
-				}
-			}
+	// The matching games are searched once for the whole list, then each game reads its score
+	if (!mTextScoresValid || mTextQuery.text != mTextFilter || mTextQuery.useRelevancy != mUseRelevency)
+	{
+		std::string language = SystemConf::getInstance()->get("system.language");
+		bool isChinese = (language == "zh_CN" || language == "zh_TW");
 
-			if (s1[i] != s2[j]) {
-				numTrans += 1;
-			}
-		}
+		mTextQuery = SearchIndex::createQuery(mTextFilter, mUseRelevency, isChinese);
+		mSearchIndex.search(mTextQuery, mTextScores);
+		mTextScoresValid = true;
 	}
 
-	float weight = (m / s1.length() + m / s2.length() + (m - (numTrans / 2)) / m) / 3;
-	float l = 0;
-	float p = 0.1;
-	if (weight > 0.7) {
-		while (s1[l] == s2[l] && l < 4) {
-			l += 1;
-		}
+	auto it = mTextScores.find(game);
+	if (it != mTextScores.cend())
+		return it->second;
 
-		weight += l * p * (1 - weight);
-	}
-	return weight;
+	if (mSearchIndex.contains(game))
+		return 0;
+
+	// Game which was not added to this index (copy of another index, collection filter...)
+	return SearchIndex::getScore(game, mTextQuery);
 }
 
 int FileFilterIndex::showFile(FileData* game)
@@ -651,169 +637,19 @@ int FileFilterIndex::showFile(FileData* game)
 
 	if (!mTextFilter.empty())
 	{
-		auto name = game->getSourceFileData()->getName();
-		std::string language = SystemConf::getInstance()->get("system.language");
-		bool isChinese = (language == "zh_CN" || language == "zh_TW");
-
-		if (!mUseRelevency)
-		{
-			if (mTextFilter.find(',') == std::string::npos)
-			{
-				if (Utils::String::containsIgnoreCase(name, mTextFilter))
-				{
-					textScore = 1;
-					keepGoing = true;
-				}
-				else if (isChinese && Utils::String::containsIgnoreCasePinyin(name, mTextFilter)) {
-					textScore = 2;
-					keepGoing = true;
-				}
-			}
-			else
-			{
-				for (auto token : Utils::String::split(mTextFilter, ',', true))
-				{
-					if (Utils::String::containsIgnoreCase(name, Utils::String::trim(token)))
-					{
-						textScore = 1;
-						keepGoing = true;
-						break;  // score=1 need break
-					}
-					else if (isChinese && Utils::String::containsIgnoreCasePinyin(name, Utils::String::trim(token)))
-					{
-						textScore = 2;
-						keepGoing = true;
-					}
-				}
-			}
-		}
-		else
-		{
-			if (Utils::String::compareIgnoreCase(name, mTextFilter) == 0)
-			{
-				keepGoing = true;
-				textScore = 1;
-			}
-			else if (Utils::String::startsWithIgnoreCase(name, mTextFilter))
-			{
-				keepGoing = true;
-				textScore = 2;
-			}
-			else if (mTextFilter.find(' ') == std::string::npos && Utils::String::containsIgnoreCase(name, mTextFilter))
-			{
-				keepGoing = true;
-				textScore = 3;
-			}
-			else if (mTextFilter.find(' ') != std::string::npos)
-			{
-				auto simplify = [](const std::string& text)
-				{
-					auto s = Utils::String::toLower(text);
-					s = Utils::String::replace(s, ":", "");
-					s = Utils::String::replace(s, ".", "");
-					s = Utils::String::replace(s, " - ", " ");
-					s = Utils::String::replace(s, "- ", " ");				
-
-					std::vector<std::string> ret;
-
-					for (auto v : Utils::String::split(s, ' '))
-					{
-						if (v.empty() || v.length() <= 2 || v == "and" || v == "not" || v == "for" || v == "the" || v == "les" || v == "des")
-							continue;
-
-						ret.push_back(v);
-					}
-
-					return ret;
-				};
-
-				auto filters = simplify(mTextFilter);
-				auto words = simplify(name);
-
-				int totalWords = 0;
-				int commonWords = 0;
-				
-				for (int i = 0; i < filters.size(); i++)
-				{
-					auto filter = filters[i];
-
-					for (auto word : words)
-					{
-						if (word == filter)
-						{
-							commonWords++;
-							break;
-						}
-					}
-
-					totalWords++;
-				}
-				
-				int continuousWords = 0;
-				int maxContinuousWords = 0;
-				int wordsAtStart = 0;
-				bool countStart = true;
-
-				for (int j = 0 ; j < words.size(); j++)
-				{
-					auto word = words[j];
-
-					for (int i = 0; i < filters.size(); i++)
-					{
-						auto filter = filters[i];
-
-						if (word == filter)
-						{
-							if (countStart && i == j)
-								wordsAtStart++;
-							else
-								countStart = false;
-
-							continuousWords++;
-
-							if (maxContinuousWords < continuousWords)
-								maxContinuousWords = continuousWords;
-
-							j++;
-
-							if (j < words.size())
-								word = words[j];
-							else
-								break;
-
-							continue;
-						}
-						else
-							countStart = false;
+		textScore = getTextScore(game);
+		if (textScore == 0)
+			return 0;
 
-						continuousWords = 0;
-					}					
-				}
-				
-				if (commonWords > 0)
-				{
-					if (commonWords > 1 || (commonWords > 0 && filters.size() == 1))
-					{
-						int sc = ((wordsAtStart * 2) + (maxContinuousWords * 3) + commonWords);
-						textScore = 1000 - sc;
-						keepGoing = true;
-					}
-					else
-					{
-						auto dist = jw_distance(mTextFilter, name, false);
-						if (dist > 0.66)
-						{
-							textScore = 1500 - (500 * dist);
-							keepGoing = true;
-						}
-					}
-				}
-			}
-		}
+		keepGoing = true;
 	}
 
 	bool hasFilter = false;
 
+	int id = getGameId(game);
+	if (id >= 0)
+		updateSelectedBitmaps();
+
 	for (auto& it : mFilterDecl)
 	{
 		FilterDataDecl& filterData = it.second;
@@ -822,138 +658,319 @@ int FileFilterIndex::showFile(FileData* game)
 		
 		hasFilter = true;
 
-		bool filterValid = false;
+		bool filterValid;
+		if (id >= 0 && filterData.type != HASMEDIA_FILTER && filterData.type != MISSING_MEDIA_FILTER)
+			filterValid = hasSelectedValue(id, filterData.type);
+		else
+			filterValid = matchesFilter(game, filterData);
 
-		if (filterData.type == HASMEDIA_FILTER)
-		{
-			auto it = mFilterDecl.find(HASMEDIA_FILTER);
-			if (it == mFilterDecl.cend())
-				break;
+		// if still nothing, then it's not a match
+		if (!filterValid)
+			return 0;		
 
-			auto keys = it->second.currentFilteredKeys;
-			if (keys == nullptr)
-				break;
+		keepGoing = true;
+	}
 
-			for (auto it : *keys)			
+	if (keepGoing && !mTextFilter.empty())
+		return textScore;
+	
+	if (mTextFilter.empty() && !hasFilter)
+		return 0;
+	
+	return keepGoing ? 1 : 0;
+}
+
+bool FileFilterIndex::matchesFilter(FileData* game, FilterDataDecl& filterData)
+{
+	bool filterValid = false;
+
+	if (filterData.type == HASMEDIA_FILTER)
+	{
+		for (auto it : *filterData.currentFilteredKeys)
+		{
+			if (it == "FALSE" || it == "TRUE") // Here for Retrocompatibility
 			{
-				if (it == "FALSE" || it == "TRUE") // Here for Retrocompatibility
+				if (game->hasAnyMedia() == (it == "TRUE"))
 				{
-					if (game->hasAnyMedia() == (it == "TRUE"))
-					{
-						filterValid = true;
-						break;
-					}
-				}				
-				else 
+					filterValid = true;
+					break;
+				}
+			}				
+			else 
+			{
+				std::string path = game->getMetadata().get(it);
+				if (!path.empty() && Utils::FileSystem::exists(path))
 				{
-					std::string path = game->getMetadata().get(it);
-					if (!path.empty() && Utils::FileSystem::exists(path))
-					{
-						filterValid = true;
-						break;
-					}
+					filterValid = true;
+					break;
 				}
-
 			}
 		}
-		else if (filterData.type == MISSING_MEDIA_FILTER)
+	}
+	else if (filterData.type == MISSING_MEDIA_FILTER)
+	{
+		for (auto it : *filterData.currentFilteredKeys)
 		{
-			auto it = mFilterDecl.find(MISSING_MEDIA_FILTER);
-			if (it == mFilterDecl.cend())
+			std::string path = game->getMetadata().get(it);
+			if (path.empty() || !Utils::FileSystem::exists(path))
+			{
+				filterValid = true;
 				break;
-
-			auto keys = it->second.currentFilteredKeys;
-			if (keys == nullptr)
+			}
+		}
+	}
+	else if (filterData.type == GENRE_FILTER)
+	{
+		for (auto val : Genres::getGenreFiltersNames(&game->getMetadata()))
+		{
+			if (isKeyBeingFilteredBy(val, filterData.type))
+			{
+				filterValid = true;
 				break;
+			}
+		}
+	}
+	else if (filterData.type == PLAYER_FILTER)
+	{
+		auto range = game->parsePlayersRange();
 
-			for (auto it : *keys)
+		if (range.first <= 0 && range.second > 0)
+			filterValid = isKeyBeingFilteredBy(std::to_string(range.second), filterData.type);
+		else if (range.second > 0)
+		{
+			for (auto flt : *filterData.currentFilteredKeys)
 			{
-				std::string path = game->getMetadata().get(it);
-				if (path.empty() || !Utils::FileSystem::exists(path))
+				int val = Utils::String::toInteger(flt);
+				if (range.first <= val && val <= range.second)
 				{
 					filterValid = true;
 					break;
 				}
 			}
-		}
-		else if (filterData.type == GENRE_FILTER)
+		}			
+	}
+	else
+	{
+		// try to find a match
+		std::string key = getIndexableKey(game, filterData.type, false);
+
+		if (filterData.type == LANG_FILTER || filterData.type == REGION_FILTER)
 		{
-			for (auto val : Genres::getGenreFiltersNames(&game->getMetadata()))
-			{
+			for (auto val : Utils::String::split(key, ','))
 				if (isKeyBeingFilteredBy(val, filterData.type))
-				{
 					filterValid = true;
-					break;
-				}
-			}
 		}
-		else if (filterData.type == PLAYER_FILTER)
+		else
+			filterValid = isKeyBeingFilteredBy(key, filterData.type);
+
+		// if we didn't find a match, try for secondary keys - i.e. publisher and dev, or first genre
+		if (!filterValid && filterData.hasSecondaryKey)
+		{
+			std::string secKey = getIndexableKey(game, filterData.type, true);
+			if (secKey != UNKNOWN_LABEL)
+				filterValid = isKeyBeingFilteredBy(secKey, filterData.type);
+		}
+	}
+
+	return filterValid;
+}
+
+void FileFilterIndex::getFilterValues(FileData* game, std::vector<std::pair<int, std::string>>& values)
+{
+	// Same matches as matchesFilter : a game has the values of the filter keys it is shown for
+	values.clear();
+
+	for (auto& it : mFilterDecl)
+	{
+		FilterDataDecl& filterData = it.second;
+		int type = filterData.type;
+
+		if (type == HASMEDIA_FILTER || type == MISSING_MEDIA_FILTER)
+			continue;
+
+		if (type == GENRE_FILTER)
+		{
+			for (auto val : Genres::getGenreFiltersNames(&game->getMetadata()))
+				values.push_back(std::make_pair(type, val));
+		}
+		else if (type == PLAYER_FILTER)
 		{
 			auto range = game->parsePlayersRange();
 
 			if (range.first <= 0 && range.second > 0)
-				filterValid = isKeyBeingFilteredBy(std::to_string(range.second), filterData.type);
+				values.push_back(std::make_pair(type, std::to_string(range.second)));
 			else if (range.second > 0)
 			{
-				auto it = mFilterDecl.find(PLAYER_FILTER);
-				if (it != mFilterDecl.cend())
-				{
-					auto fltKeys = it->second.currentFilteredKeys;					
-					if (fltKeys != nullptr)
-					{
-						for (auto flt : *fltKeys)
-						{
-							int val = Utils::String::toInteger(flt);
-							if (range.first <= val && val <= range.second)
-							{
-								filterValid = true;
-								break;
-							}
-						}
-					}
-				}
-			}			
+				for (int i = range.first; i <= range.second && i <= MAX_PLAYERS_FILTER; i++)
+					values.push_back(std::make_pair(type, std::to_string(i)));
+			}
 		}
 		else
 		{
-			// try to find a match
 			std::string key = getIndexableKey(game, filterData.type, false);
 
-			if (filterData.type == LANG_FILTER || filterData.type == REGION_FILTER)
+			if (type == LANG_FILTER || type == REGION_FILTER)
 			{
 				for (auto val : Utils::String::split(key, ','))
-					if (isKeyBeingFilteredBy(val, filterData.type))
-						filterValid = true;
+					values.push_back(std::make_pair(type, val));
 			}
 			else
-				filterValid = isKeyBeingFilteredBy(key, filterData.type);
+				values.push_back(std::make_pair(type, key));
 
-			// if we didn't find a match, try for secondary keys - i.e. publisher and dev, or first genre
-			if (!filterValid)
+			if (filterData.hasSecondaryKey)
 			{
-				if (!filterData.hasSecondaryKey)
-					return 0;
-
 				std::string secKey = getIndexableKey(game, filterData.type, true);
 				if (secKey != UNKNOWN_LABEL)
-					filterValid = isKeyBeingFilteredBy(secKey, filterData.type);
+					values.push_back(std::make_pair(type, secKey));
 			}
 		}
+	}
+}
 
-		// if still nothing, then it's not a match
-		if (!filterValid)
-			return 0;		
+int FileFilterIndex::getGameId(FileData* game)
+{
+	int id = mBitmaps.getId(game);
+	if (id >= 0 && !mBitmaps.isUpToDate(id))
+	{
+		std::vector<std::pair<int, std::string>> values;
+		getFilterValues(game, values);
+		mBitmaps.setValues(id, values);
+	}
 
-		keepGoing = true;
+	return id;
+}
+
+void FileFilterIndex::onFiltersChanged()
+{
+	mSelectedBitmapsValid = false;
+	mShownGames.clear();
+}
+
+void FileFilterIndex::updateSelectedBitmaps()
+{
+	if (mSelectedBitmapsValid && mSelectedBitmapsLayout == mBitmaps.getLayoutVersion())
+		return;
+
+	mSelectedBitmaps.clear();
+
+	for (auto& it : mFilterDecl)
+	{
+		FilterDataDecl& filterData = it.second;
+		if (!(*(filterData.filteredByRef)))
+			continue;
+
+		int type = filterData.type;
+		if (type >= (int)mSelectedBitmaps.size())
+			mSelectedBitmaps.resize(type + 1);
+
+		for (auto& key : *filterData.currentFilteredKeys)
+		{
+			auto bitmap = mBitmaps.getBitmap(type, key);
+			if (bitmap != nullptr)
+				mSelectedBitmaps[type].push_back(bitmap);
+		}
 	}
 
-	if (keepGoing && !mTextFilter.empty())
-		return textScore;
-	
-	if (mTextFilter.empty() && !hasFilter)
-		return 0;
-	
-	return keepGoing ? 1 : 0;
+	mSelectedBitmapsValid = true;
+	mSelectedBitmapsLayout = mBitmaps.getLayoutVersion();
+}
+
+bool FileFilterIndex::hasSelectedValue(int id, int type)
+{
+	if (type >= (int)mSelectedBitmaps.size())
+		return false;
+
+	for (auto bitmap : mSelectedBitmaps[type])
+		if (FilterBitmaps::test(*bitmap, id))
+			return true;
+
+	return false;
+}
+
+const FilterBitmaps::Bitmap& FileFilterIndex::getShownGames(int excludedType)
+{
+	if (mShownGamesVersion != mBitmaps.getVersion())
+	{
+		mShownGames.clear();
+		mShownGamesVersion = mBitmaps.getVersion();
+	}
+
+	auto cached = mShownGames.find(excludedType);
+	if (cached != mShownGames.cend())
+		return cached->second;
+
+	updateSelectedBitmaps();
+
+	FilterBitmaps::Bitmap shown = mBitmaps.getGames();
+
+	std::vector<FilterDataDecl*> perGameFilters;
+
+	for (auto& it : mFilterDecl)
+	{
+		FilterDataDecl& filterData = it.second;
+		if (!(*(filterData.filteredByRef)) || filterData.type == excludedType)
+			continue;
+
+		if (filterData.type == HASMEDIA_FILTER || filterData.type == MISSING_MEDIA_FILTER)
+		{
+			perGameFilters.push_back(&filterData);
+			continue;
+		}
+
+		FilterBitmaps::Bitmap selected;
+		if (filterData.type < (int)mSelectedBitmaps.size())
+			for (auto bitmap : mSelectedBitmaps[filterData.type])
+				FilterBitmaps::unite(selected, *bitmap);
+
+		FilterBitmaps::intersect(shown, selected);
+	}
+
+	// Text & media filters are checked game by game, only for the games the bitmaps kept
+	if (!mTextFilter.empty() || perGameFilters.size() > 0)
+	{
+		for (int id = 0; id < mBitmaps.size(); id++)
+		{
+			if (!FilterBitmaps::test(shown, id))
+				continue;
+
+			FileData* game = mBitmaps.getGame(id);
+
+			bool show = mTextFilter.empty() || getTextScore(game) != 0;
+			for (auto filterData : perGameFilters)
+				if (show && !matchesFilter(game, *filterData))
+					show = false;
+
+			if (!show)
+				FilterBitmaps::set(shown, id, false);
+		}
+	}
+
+	return mShownGames[excludedType] = shown;
+}
+
+std::map<std::string, int> FileFilterIndex::getGameCounts(FilterIndexType type)
+{
+	std::map<std::string, int> ret;
+
+	// Media filters check the files of each game : too slow to count them for every key. Collection filters have no games
+	auto it = mFilterDecl.find(type);
+	if (it == mFilterDecl.cend() || type == HASMEDIA_FILTER || type == MISSING_MEDIA_FILTER || mBitmaps.getGameCount() == 0)
+		return ret;
+
+	// Games whose metadata changed get their new values
+	for (int id = 0; id < mBitmaps.size(); id++)
+		if (mBitmaps.getGame(id) != nullptr)
+			getGameId(mBitmaps.getGame(id));
+
+	auto& shown = getShownGames(type);
+
+	for (auto& key : *it->second.allIndexKeys)
+	{
+		auto bitmap = mBitmaps.getBitmap(type, key.first);
+		ret[key.first] = (bitmap == nullptr ? 0 : FilterBitmaps::countCommon(*bitmap, shown));
+	}
+
+	return ret;
 }
 
 bool FileFilterIndex::isKeyBeingFilteredBy(std::string key, FilterIndexType type)
@@ -1116,6 +1133,8 @@ bool CollectionFilter::createFromSystem(const std::string name, SystemData* syst
 		*(filterData.filteredByRef) = (filterData.currentFilteredKeys->size() > 0);
 	}
 
+	onFiltersChanged();
+
 	mName = name;
 	mPath = getCollectionsFolder() + "/" + mName + ".xcc";
 	
@@ -1212,6 +1231,8 @@ bool CollectionFilter::load(const std::string file)
 		*(filterData.filteredByRef) = (filterData.currentFilteredKeys->size() > 0);
 	}
 
+	onFiltersChanged();
+
 	return true;
 }
 
@@ -1317,6 +1338,14 @@ int CollectionFilter::showFile(FileData* game)
 	return FileFilterIndex::showFile(game);
 }
 
+std::string CollectionFilter::getFilterSignature()
+{
+	std::vector<std::string> systems(mSystemFilter.cbegin(), mSystemFilter.cend());
+	std::sort(systems.begin(), systems.end());
+
+	return FileFilterIndex::getFilterSignature() + "\nsystems:" + Utils::String::join(systems, "\t");
+}
+
 bool CollectionFilter::isSystemSelected(const std::string name)
 {
 	if (mSystemFilter.size() == 0)
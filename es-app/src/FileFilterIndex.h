@@ -4,8 +4,11 @@
 
 #include <map>
 #include <vector>
+#include <unordered_map>
 #include <unordered_set>
 #include <string>
+#include "SearchIndex.h"
+#include "FilterBitmaps.h"
 
 class FileData;
 class SystemData;
@@ -86,6 +89,12 @@ public:
 
 	std::string getDisplayLabel(bool includeText = false);
 
+	// Same signature, same filters : used to reuse a list filtered before
+	virtual std::string getFilterSignature();
+
+	// Number of games having each key of the filter, among the games shown by the other filters. Empty for the media filters
+	std::map<std::string, int> getGameCounts(FilterIndexType type);
+
 protected:
 	//std::vector<FilterDataDecl> filterDataDecl;
 	std::map<int, FilterDataDecl> mFilterDecl;
@@ -104,6 +113,25 @@ protected:
 
 	void clearIndex(std::map<std::string, int> indexMap);
 
+	int getTextScore(FileData* game);
+
+	bool matchesFilter(FileData* game, FilterDataDecl& filterData);
+
+	// Keys of every filter the game is shown for, except the media filters which check files
+	void getFilterValues(FileData* game, std::vector<std::pair<int, std::string>>& values);
+
+	// Id of the game in mBitmaps with its values up to date, -1 if it is not indexed
+	int getGameId(FileData* game);
+
+	void onFiltersChanged();
+	void updateSelectedBitmaps();
+	bool hasSelectedValue(int id, int type);
+
+	// Games shown by all the filters but the excluded one
+	const FilterBitmaps::Bitmap& getShownGames(int excludedType);
+
+	static const int MAX_PLAYERS_FILTER = 99;
+
 	bool filterByGenre;
 	bool filterByFamily;
 	bool filterByPlayers;
@@ -166,6 +194,19 @@ protected:
 
 	std::string mTextFilter;
 	bool		mUseRelevency;
+
+	SearchIndex mSearchIndex;
+	SearchIndex::Query mTextQuery;
+	std::unordered_map<FileData*, int> mTextScores;
+	bool		mTextScoresValid;
+
+	FilterBitmaps mBitmaps;
+	std::vector<std::vector<const FilterBitmaps::Bitmap*>> mSelectedBitmaps; // by filter type : bitmaps of the filtered keys
+	bool		mSelectedBitmapsValid;
+	unsigned int mSelectedBitmapsLayout;
+
+	std::map<int, FilterBitmaps::Bitmap> mShownGames; // by excluded filter type
+	unsigned int mShownGamesVersion;
 };
 
 class CollectionFilter : public FileFilterIndex
@@ -179,6 +220,7 @@ public:
 
 	int showFile(FileData* game) override;
 	bool isFiltered() override;
+	std::string getFilterSignature() override;
 
 	bool isSystemSelected(const std::string name);
 	void setSystemSelected(const std::string name, bool value);
@@ -71,23 +71,47 @@ namespace FileSorts
 		mSortTypes.push_back(SortType(RELEASEDATE_SYSTEM_DESCENDING, &compareReleaseYearSystem, false, _("RELEASE YEAR, SYSTEM, DESCENDING"), _U("\uF161 ")));
 	}
 
-	//returns if file1 should come before file2
-	bool compareName(const FileData* file1, const FileData* file2)
+	bool SortKeys::isUpToDate(FileData* file) const
+	{
+		return computed &&
+			version == file->getMetadata().getVersion() &&
+			ignoreLeadingArticles == Settings::IgnoreLeadingArticles() &&
+			showFilenames == (file->getSystem() != nullptr && file->getSystem()->getShowFilenames());
+	}
+
+	void SortKeys::update(FileData* file)
 	{
+		auto& metadata = file->getMetadata();
+
+		computed = true;
+		version = metadata.getVersion();
+		ignoreLeadingArticles = Settings::IgnoreLeadingArticles();
+		showFilenames = file->getSystem() != nullptr && file->getSystem()->getShowFilenames();
+
 		// we compare the actual metadata name, as collection files have the system appended which messes up the order
-		const std::string& name1 = ((FileData *) file1)->getName();
-		const std::string& name2 = ((FileData *) file2)->getName();
+		const std::string& fileName = file->getName();
+		fullName = Utils::String::getIgnoreCaseSortKey(fileName);
 
-		if (Settings::IgnoreLeadingArticles())
+		if (ignoreLeadingArticles)
 		{
 			static auto articles = Utils::String::commaStringToVector(_("A,AN,THE"));
-			auto name1a = stripLeadingArticle(name1, articles);
-			auto name2a = stripLeadingArticle(name2, articles);
-
-			return Utils::String::compareIgnoreCase(name1a, name2a) < 0;
+			name = Utils::String::getIgnoreCaseSortKey(stripLeadingArticle(fileName, articles));
 		}
+		else
+			name = fullName;
 
-		return Utils::String::compareIgnoreCase(name1, name2) < 0;
+		genre = Utils::String::getIgnoreCaseSortKey(metadata.get(MetaDataId::Genre));
+		developer = Utils::String::getIgnoreCaseSortKey(metadata.get(MetaDataId::Developer));
+		publisher = Utils::String::getIgnoreCaseSortKey(metadata.get(MetaDataId::Publisher));
+		system = Utils::String::getIgnoreCaseSortKey(file->getSystemName());
+		year = metadata.get(MetaDataId::ReleaseDate).substr(0, 4);
+		players = metadata.getInt(MetaDataId::Players);
+	}
+
+	//returns if file1 should come before file2
+	bool compareName(const FileData* file1, const FileData* file2)
+	{
+		return ((FileData*)file1)->getSortKeys().name < ((FileData*)file2)->getSortKeys().name;
 	}
 
 	std::string stripLeadingArticle(const std::string &string, const std::vector<std::string> &articles)
@@ -134,58 +158,50 @@ namespace FileSorts
 
 	bool compareLastPlayed(const FileData* file1, const FileData* file2)
 	{
-		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
-		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->getMetadata().get(MetaDataId::LastPlayed) < (file2)->getMetadata().get(MetaDataId::LastPlayed);
+		// ISO dates (YYYYMMDDTHHMMSS) are kept as numbers : compared without formatting them
+		return (file1)->getMetadata().isLess(MetaDataId::LastPlayed, (file2)->getMetadata());
 	}
 
 	bool compareNumPlayers(const FileData* file1, const FileData* file2)
 	{
-		return (file1)->getMetadata().getInt(MetaDataId::Players) < (file2)->getMetadata().getInt(MetaDataId::Players);
+		return ((FileData*)file1)->getSortKeys().players < ((FileData*)file2)->getSortKeys().players;
 	}
 
 	bool compareSystemReleaseYear(const FileData* file1, const FileData* file2)
 	{
-		std::string system1 = ((FileData*)file1)->getSourceFileData()->getSystemName();
-		std::string system2 = ((FileData*)file2)->getSourceFileData()->getSystemName();
+		auto& keys1 = ((FileData*)file1)->getSortKeys();
+		auto& keys2 = ((FileData*)file2)->getSortKeys();
 
-		if (system1 == system2)
+		if (keys1.system == keys2.system)
 		{
-			std::string year1 = file1->getMetadata().get(MetaDataId::ReleaseDate).substr(0, 4);
-			std::string year2 = file2->getMetadata().get(MetaDataId::ReleaseDate).substr(0, 4);
-
-			if (year1 == year2)
-				return Utils::String::compareIgnoreCase(((FileData*)file1)->getName(), ((FileData*)file2)->getName()) < 0;
+			if (keys1.year == keys2.year)
+				return keys1.fullName < keys2.fullName;
 
-			return year1 < year2;
+			return keys1.year < keys2.year;
 		}
-		return Utils::String::compareIgnoreCase(system1, system2) < 0;
+		return keys1.system < keys2.system;
 	}
 
 	bool compareReleaseYearSystem(const FileData* file1, const FileData* file2)
 	{
-		std::string year1 = file1->getMetadata().get(MetaDataId::ReleaseDate).substr(0, 4);
-		std::string year2 = file2->getMetadata().get(MetaDataId::ReleaseDate).substr(0, 4);
+		auto& keys1 = ((FileData*)file1)->getSortKeys();
+		auto& keys2 = ((FileData*)file2)->getSortKeys();
 
-		if (year1 == year2)
+		if (keys1.year == keys2.year)
 		{
-			std::string system1 = ((FileData*)file1)->getSourceFileData()->getSystemName();
-			std::string system2 = ((FileData*)file2)->getSourceFileData()->getSystemName();
-
-			if (system1 == system2)
-				return Utils::String::compareIgnoreCase(((FileData*)file1)->getName(), ((FileData*)file2)->getName()) < 0;
+			if (keys1.system == keys2.system)
+				return keys1.fullName < keys2.fullName;
 
-			return Utils::String::compareIgnoreCase(system1, system2) < 0;
+			return keys1.system < keys2.system;
 		}
 
-		return year1 < year2;
+		return keys1.year < keys2.year;
 	}
 
 	bool compareReleaseDate(const FileData* file1, const FileData* file2)
 	{
-		// since it's stored as an ISO string (YYYYMMDDTHHMMSS), we can compare as a string
-		// as it's a lot faster than the time casts and then time comparisons
-		return (file1)->getMetadata().get(MetaDataId::ReleaseDate) < (file2)->getMetadata().get(MetaDataId::ReleaseDate);
+		// ISO dates (YYYYMMDDTHHMMSS) are kept as numbers : compared without formatting them
+		return (file1)->getMetadata().isLess(MetaDataId::ReleaseDate, (file2)->getMetadata());
 	}
 
 	bool compareFileCreationDate(const FileData* file1, const FileData* file2)
@@ -198,29 +214,21 @@ namespace FileSorts
 
 	bool compareGenre(const FileData* file1, const FileData* file2)
 	{
-		std::string genre1 = file1->getMetadata().get(MetaDataId::Genre);
-		std::string genre2 = file2->getMetadata().get(MetaDataId::Genre);
-		return Utils::String::compareIgnoreCase(genre1, genre2) < 0;
+		return ((FileData*)file1)->getSortKeys().genre < ((FileData*)file2)->getSortKeys().genre;
 	}
 
 	bool compareDeveloper(const FileData* file1, const FileData* file2)
 	{
-		std::string developer1 = file1->getMetadata().get(MetaDataId::Developer);
-		std::string developer2 = file2->getMetadata().get(MetaDataId::Developer);
-		return Utils::String::compareIgnoreCase(developer1, developer2) < 0;
+		return ((FileData*)file1)->getSortKeys().developer < ((FileData*)file2)->getSortKeys().developer;
 	}
 
 	bool comparePublisher(const FileData* file1, const FileData* file2)
 	{
-		std::string publisher1 = file1->getMetadata().get(MetaDataId::Publisher);
-		std::string publisher2 = file2->getMetadata().get(MetaDataId::Publisher);
-		return Utils::String::compareIgnoreCase(publisher1, publisher2) < 0;
+		return ((FileData*)file1)->getSortKeys().publisher < ((FileData*)file2)->getSortKeys().publisher;
 	}
 
 	bool compareSystem(const FileData* file1, const FileData* file2)
 	{
-		std::string system1 = ((FileData*)file1)->getSourceFileData()->getSystemName();
-		std::string system2 = ((FileData*)file2)->getSourceFileData()->getSystemName();
-		return Utils::String::compareIgnoreCase(system1, system2) < 0;		
+		return ((FileData*)file1)->getSortKeys().system < ((FileData*)file2)->getSortKeys().system;
 	}
 };
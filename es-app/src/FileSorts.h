@@ -42,6 +42,30 @@ namespace FileSorts
 
 	typedef bool ComparisonFunction(const FileData* a, const FileData* b);
 
+	// Values compared by the comparators, computed once per game by FileData::getSortKeys instead of at each comparison
+	struct SortKeys
+	{
+		SortKeys() : computed(false), version(0), ignoreLeadingArticles(false), showFilenames(false), players(0) { }
+
+		bool isUpToDate(FileData* file) const;
+		void update(FileData* file);
+
+		bool computed;
+		unsigned int version;		// of the metadata the keys were computed from
+		bool ignoreLeadingArticles;
+		bool showFilenames;
+
+		// Texts are folded by Utils::String::getIgnoreCaseSortKey : comparing them gives the order of compareIgnoreCase
+		std::string name;			// without its leading article if IgnoreLeadingArticles is set
+		std::string fullName;
+		std::string genre;
+		std::string developer;
+		std::string publisher;
+		std::string system;
+		std::string year;
+		int players;
+	};
+
 	struct SortType
 	{
 		int id;
@@ -0,0 +1,211 @@
+#include "FilterBitmaps.h"
+
+#include "FileData.h"
+
+#include <algorithm>
+#include <bitset>
+
+FilterBitmaps::FilterBitmaps() : mLayoutVersion(0), mVersion(0)
+{
+
+}
+
+int FilterBitmaps::getId(FileData* game) const
+{
+	auto it = mIds.find(game);
+	if (it == mIds.cend())
+		return -1;
+
+	return it->second;
+}
+
+int FilterBitmaps::add(FileData* game)
+{
+	int id = getId(game);
+	if (id >= 0)
+		return id;
+
+	if (mFreeIds.size() > 0)
+	{
+		id = mFreeIds.back();
+		mFreeIds.pop_back();
+	}
+	else
+	{
+		id = (int)mGames.size();
+		mGames.push_back(Game());
+	}
+
+	Game& entry = mGames[id];
+	entry.game = game;
+	entry.hasValues = false;
+	entry.version = 0;
+	entry.values.clear();
+
+	mIds[game] = id;
+	set(mAllGames, id, true);
+	mVersion++;
+
+	return id;
+}
+
+void FilterBitmaps::remove(FileData* game)
+{
+	auto it = mIds.find(game);
+	if (it == mIds.cend())
+		return;
+
+	int id = it->second;
+	mIds.erase(it);
+
+	clearValues(id);
+	mGames[id].game = nullptr;
+	mGames[id].hasValues = false;
+
+	set(mAllGames, id, false);
+	mFreeIds.push_back(id);
+	mVersion++;
+}
+
+void FilterBitmaps::clear()
+{
+	mIds.clear();
+	mGames.clear();
+	mFreeIds.clear();
+	mAllGames.clear();
+	mValues.clear();
+	mBitmaps.clear();
+
+	mLayoutVersion++;
+	mVersion++;
+}
+
+bool FilterBitmaps::isUpToDate(int id) const
+{
+	const Game& entry = mGames[id];
+	return entry.hasValues && entry.version == entry.game->getMetadata().getVersion();
+}
+
+void FilterBitmaps::setValues(int id, const std::vector<std::pair<int, std::string>>& values)
+{
+	clearValues(id);
+
+	Game& entry = mGames[id];
+	entry.hasValues = true;
+	entry.version = entry.game->getMetadata().getVersion();
+
+	for (auto& value : values)
+	{
+		if (value.first >= (int)mValues.size())
+			mValues.resize(value.first + 1);
+
+		auto& typeValues = mValues[value.first];
+
+		int index;
+
+		auto it = typeValues.find(value.second);
+		if (it != typeValues.cend())
+			index = it->second;
+		else
+		{
+			index = (int)mBitmaps.size();
+			mBitmaps.push_back(Bitmap());
+			typeValues[value.second] = index;
+			mLayoutVersion++;
+		}
+
+		set(mBitmaps[index], id, true);
+		entry.values.push_back(index);
+	}
+
+	mVersion++;
+}
+
+void FilterBitmaps::clearValues(int id)
+{
+	Game& entry = mGames[id];
+
+	for (auto index : entry.values)
+		set(mBitmaps[index], id, false);
+
+	entry.values.clear();
+}
+
+const FilterBitmaps::Bitmap* FilterBitmaps::getBitmap(int type, const std::string& value) const
+{
+	if (type >= (int)mValues.size())
+		return nullptr;
+
+	auto& typeValues = mValues[type];
+
+	auto it = typeValues.find(value);
+	if (it == typeValues.cend())
+		return nullptr;
+
+	return &mBitmaps[it->second];
+}
+
+bool FilterBitmaps::test(const Bitmap& bitmap, int id)
+{
+	size_t word = (size_t)id >> 6;
+	if (word >= bitmap.size())
+		return false;
+
+	return (bitmap[word] & (1ULL << (id & 63))) != 0;
+}
+
+void FilterBitmaps::set(Bitmap& bitmap, int id, bool value)
+{
+	size_t word = (size_t)id >> 6;
+	if (word >= bitmap.size())
+	{
+		if (!value)
+			return;
+
+		bitmap.resize(word + 1, 0);
+	}
+
+	if (value)
+		bitmap[word] |= (1ULL << (id & 63));
+	else
+		bitmap[word] &= ~(1ULL << (id & 63));
+}
+
+void FilterBitmaps::intersect(Bitmap& bitmap, const Bitmap& other)
+{
+	if (bitmap.size() > other.size())
+		bitmap.resize(other.size());
+
+	for (size_t i = 0; i < bitmap.size(); i++)
+		bitmap[i] &= other[i];
+}
+
+void FilterBitmaps::unite(Bitmap& bitmap, const Bitmap& other)
+{
+	if (bitmap.size() < other.size())
+		bitmap.resize(other.size(), 0);
+
+	for (size_t i = 0; i < other.size(); i++)
+		bitmap[i] |= other[i];
+}
+
+int FilterBitmaps::count(const Bitmap& bitmap)
+{
+	size_t ret = 0;
+
+	for (auto word : bitmap)
+		ret += std::bitset<64>(word).count();
+
+	return (int)ret;
+}
+
+int FilterBitmaps::countCommon(const Bitmap& bitmap, const Bitmap& other)
+{
+	size_t ret = 0;
+	size_t size = std::min(bitmap.size(), other.size());
+
+	for (size_t i = 0; i < size; i++)
+		ret += std::bitset<64>(bitmap[i] & other[i]).count();
+
+	return (int)ret;
+}
@@ -0,0 +1,83 @@
+#pragma once
+#ifndef ES_APP_FILTER_BITMAPS_H
+#define ES_APP_FILTER_BITMAPS_H
+
+#include <cstdint>
+#include <deque>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+class FileData;
+
+// Filter values of the games of a FileFilterIndex. Each game gets a dense id, and each value of a filter a bitmap of the
+// ids of the games having it : checking a game against the filters tests a few bits, and counting the games shown by
+// some filters is a popcount of the AND / OR of their bitmaps.
+// The values of a game are computed again when its metadata changed since they were set.
+class FilterBitmaps
+{
+public:
+	typedef std::vector<std::uint64_t> Bitmap;
+
+	FilterBitmaps();
+
+	// -1 if the game is not in the index
+	int getId(FileData* game) const;
+
+	int add(FileData* game);
+	void remove(FileData* game);
+	void clear();
+
+	// Ids are below size(), getGame returns nullptr for the ids of removed games
+	inline int size() const { return (int)mGames.size(); }
+	inline FileData* getGame(int id) const { return mGames[id].game; }
+
+	inline int getGameCount() const { return (int)mIds.size(); }
+
+	// Bitmap of the ids in use
+	inline const Bitmap& getGames() const { return mAllGames; }
+
+	bool isUpToDate(int id) const;
+	void setValues(int id, const std::vector<std::pair<int, std::string>>& values);
+
+	// nullptr if no game ever had this value. Returned pointers stay valid until clear()
+	const Bitmap* getBitmap(int type, const std::string& value) const;
+
+	// Incremented when a value appears : filters looking for a value nobody had must look again
+	inline unsigned int getLayoutVersion() const { return mLayoutVersion; }
+
+	// Incremented when a game is added, removed or changes its values
+	inline unsigned int getVersion() const { return mVersion; }
+
+	static bool test(const Bitmap& bitmap, int id);
+	static void set(Bitmap& bitmap, int id, bool value);
+	static void intersect(Bitmap& bitmap, const Bitmap& other);
+	static void unite(Bitmap& bitmap, const Bitmap& other);
+	static int count(const Bitmap& bitmap);
+	static int countCommon(const Bitmap& bitmap, const Bitmap& other);
+
+private:
+	struct Game
+	{
+		FileData* game;
+		bool hasValues;
+		unsigned int version;		// of the metadata the values were computed from
+		std::vector<int> values;	// indexes in mBitmaps
+	};
+
+	void clearValues(int id);
+
+	std::unordered_map<FileData*, int> mIds;
+	std::vector<Game> mGames;
+	std::vector<int> mFreeIds;
+	Bitmap mAllGames;
+
+	std::vector<std::unordered_map<std::string, int>> mValues; // by filter type : value -> index in mBitmaps
+	std::deque<Bitmap> mBitmaps;
+
+	unsigned int mLayoutVersion;
+	unsigned int mVersion;
+};
+
+#endif // ES_APP_FILTER_BITMAPS_H
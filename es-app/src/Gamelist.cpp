@@ -9,6 +9,7 @@
 #include "SystemData.h"
 #include <pugixml/src/pugixml.hpp>
 #include "Genres.h"
+#include "LibraryCache.h"
 #include "Paths.h"
 
 #ifdef WIN32
@@ -349,7 +350,7 @@ bool hasDirtyFile(SystemData* system)
 	return false;
 }
 
-void updateGamelist(SystemData* system)
+bool updateGamelist(SystemData* system)
 {
 	// We do this by reading the XML again, adding changes and then writing it back,
 	// because there might be information missing in our systemdata which would then miss in the new XML.
@@ -357,16 +358,16 @@ void updateGamelist(SystemData* system)
 	// we already have in the system from the XML, and then add it back from its GameData information...
 
 	if (system == nullptr || Settings::IgnoreGamelist())
-		return;
+		return true;
 
 	if (!system->isGameSystem() || system->isCollection() || (!Settings::HiddenSystemsShowGames() && system->isHidden()))
-		return;
+		return true;
 
 	FolderData* rootFolder = system->getRootFolder();
 	if (rootFolder == nullptr)
 	{
 		LOG(LogError) << "Found no root folder for system \"" << system->getName() << "\"!";
-		return;
+		return false;
 	}
 
 	std::vector<FileData*> dirtyFiles;
@@ -379,7 +380,7 @@ void updateGamelist(SystemData* system)
 	if (dirtyFiles.size() == 0)
 	{
 		clearTemporaryGamelistRecovery(system);
-		return;
+		return true;
 	}
 
 	int numUpdated = 0;
@@ -450,12 +451,18 @@ void updateGamelist(SystemData* system)
 		LOG(LogInfo) << "Added/Updated " << numUpdated << " entities in '" << xmlReadPath << "'";
 
 		if (!doc.save_file(WINSTRINGW(xmlWritePath).c_str()))
+		{
 			LOG(LogError) << "Error saving gamelist.xml to \"" << xmlWritePath << "\" (for system " << system->getName() << ")!";
-		else
-			clearTemporaryGamelistRecovery(system);
+			return false;
+		}
+
+		clearTemporaryGamelistRecovery(system);
+		LibraryCache::updateGamelistStamp(system);
 	}
 	else
 		clearTemporaryGamelistRecovery(system);
+
+	return true;
 }
 
 void resetGamelistUsageData(SystemData* system)
@@ -13,8 +13,8 @@ class FileData;
 // Loads gamelist.xml data into a SystemData.
 void parseGamelist(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap);
 
-// Writes currently loaded metadata for a SystemData to gamelist.xml.
-void updateGamelist(SystemData* system);
+// Writes currently loaded metadata for a SystemData to gamelist.xml. Returns false if the changes could not be written.
+bool updateGamelist(SystemData* system);
 void cleanupGamelist(SystemData* system);
 void resetGamelistUsageData(SystemData* system);
 
@@ -25,6 +25,8 @@ bool saveToXml(FileData* file, const std::string& fileName, bool fullPaths = fal
 
 bool hasDirtyFile(SystemData* system);
 
+std::string getGamelistRecoveryPath(SystemData* system);
+
 std::vector<FileData*> loadGamelistFile(const std::string xmlpath, SystemData* system, std::unordered_map<std::string, FileData*>& fileMap, size_t checkSize = SIZE_MAX, bool fromFile = true);
 
 #endif // ES_APP_GAME_LIST_H
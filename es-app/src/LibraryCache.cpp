@@ -0,0 +1,489 @@
+#include "LibraryCache.h"
+
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "FileData.h"
+#include "Gamelist.h"
+#include "Log.h"
+#include "MetaData.h"
+#include "Paths.h"
+#include "Settings.h"
+#include "SystemData.h"
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <stack>
+
+// Increase when the layout of the file changes
+#define LIBRARY_CACHE_VERSION 1
+
+static const char LIBRARY_CACHE_MAGIC[4] = { 'E', 'S', 'L', 'C' };
+
+// Values are written with the native byte order : the snapshot never leaves the machine which wrote it
+class LibraryWriter
+{
+public:
+	void writeByte(unsigned char value) { mData.push_back((char)value); }
+	void writeInt(unsigned int value) { mData.append((const char*)&value, sizeof(value)); }
+	void writeLong(long long value) { mData.append((const char*)&value, sizeof(value)); }
+
+	void writeString(const std::string& value)
+	{
+		writeInt((unsigned int)value.size());
+		mData.append(value);
+	}
+
+	void writeStamp(const LibrarySources::Stamp& stamp)
+	{
+		writeString(stamp.path);
+		writeLong(stamp.time);
+		writeLong((long long)stamp.size);
+	}
+
+	const std::string& data() { return mData; }
+
+private:
+	std::string mData;
+};
+
+// Reads from the whole file loaded in memory. Any read past the end makes the snapshot invalid.
+class LibraryReader
+{
+public:
+	LibraryReader(const std::vector<char>& data) : mPos(data.data()), mEnd(data.data() + data.size()), mValid(true) { }
+
+	bool isValid() { return mValid; }
+
+	unsigned char readByte()
+	{
+		if (!check(1))
+			return 0;
+
+		return (unsigned char)*mPos++;
+	}
+
+	unsigned int readInt()
+	{
+		unsigned int value = 0;
+		if (check(sizeof(value)))
+		{
+			memcpy(&value, mPos, sizeof(value));
+			mPos += sizeof(value);
+		}
+
+		return value;
+	}
+
+	long long readLong()
+	{
+		long long value = 0;
+		if (check(sizeof(value)))
+		{
+			memcpy(&value, mPos, sizeof(value));
+			mPos += sizeof(value);
+		}
+
+		return value;
+	}
+
+	std::string readString()
+	{
+		unsigned int size = readInt();
+		if (!check(size))
+			return std::string();
+
+		std::string value(mPos, size);
+		mPos += size;
+		return value;
+	}
+
+	LibrarySources::Stamp readStamp()
+	{
+		LibrarySources::Stamp stamp;
+		stamp.path = readString();
+		stamp.time = readLong();
+		stamp.size = (unsigned long long)readLong();
+		return stamp;
+	}
+
+private:
+	bool check(size_t size)
+	{
+		if (mValid && (size_t)(mEnd - mPos) >= size)
+			return true;
+
+		mValid = false;
+		return false;
+	}
+
+	const char* mPos;
+	const char* mEnd;
+	bool mValid;
+};
+
+bool LibraryCache::isEnabled()
+{
+	return Settings::LibraryCache() && !Settings::IgnoreGamelist();
+}
+
+std::string LibraryCache::getCachePath(SystemData* system)
+{
+	return Paths::getUserEmulationStationPath() + "/cache/library/" + system->getName() + ".bin";
+}
+
+std::string LibraryCache::getSignature(SystemData* system)
+{
+	bool showHidden = Settings::ShowHiddenFiles();
+
+	auto shv = Settings::getInstance()->getString(system->getName() + ".ShowHiddenFiles");
+	if (shv == "1") showHidden = true;
+	else if (shv == "0") showHidden = false;
+
+	std::string signature = system->getStartPath() + "|" + system->getFullName() + "|";
+
+	for (auto extension : system->getExtensions())
+		signature += extension + " ";
+
+	for (auto platform : system->getPlatformIds())
+		signature += "|" + std::to_string((int)platform);
+
+	signature += "|" + std::string(showHidden ? "1" : "0");
+	signature += std::string(Settings::ParseGamelistOnly() ? "1" : "0");
+	signature += std::string(Settings::RemoveMultiDiskContent() ? "1" : "0");
+	signature += std::string(Settings::PreloadMedias() ? "1" : "0");
+
+	// Metadata ids are written as numbers
+	for (auto mdd : MetaDataList::getMDD())
+		signature += "|" + mdd.key;
+
+	return signature;
+}
+
+void LibraryCache::stampFile(LibrarySources::Stamp& stamp, const std::string& path)
+{
+	stamp.path = path;
+	stamp.time = (long long)Utils::FileSystem::getFileModificationDate(path).getTime();
+	stamp.size = Utils::FileSystem::getFileSize(path);
+}
+
+void LibraryCache::stampFolder(LibrarySources::Stamp& stamp, const std::string& path)
+{
+	// Adding, removing or renaming an entry changes the date of the folder
+	stamp.path = path;
+	stamp.time = (long long)Utils::FileSystem::getFileModificationDate(path).getTime();
+	stamp.size = 0;
+}
+
+bool LibraryCache::isUpToDate(const LibrarySources& sources)
+{
+	LibrarySources::Stamp stamp;
+
+	stampFile(stamp, sources.gamelist.path);
+	if (stamp.time != sources.gamelist.time || stamp.size != sources.gamelist.size)
+		return false;
+
+	for (const auto& folder : sources.folders)
+	{
+		stampFolder(stamp, folder.path);
+		if (stamp.time != folder.time)
+			return false;
+	}
+
+	return true;
+}
+
+bool LibraryCache::load(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap)
+{
+	LibrarySources* sources = new LibrarySources();
+	sources->signature = getSignature(system);
+	stampFile(sources->gamelist, system->getGamelistPath(false));
+
+	if (system->mLibrarySources != nullptr)
+		delete system->mLibrarySources;
+
+	system->mLibrarySources = sources;
+
+	// Games saved in the recovery folder are not in gamelist.xml yet
+	if (Utils::FileSystem::getDirContent(getGamelistRecoveryPath(system), true).size() > 0)
+		return false;
+
+	std::string path = getCachePath(system);
+
+	std::ifstream file(WINSTRINGW(path), std::ios::binary | std::ios::ate);
+	if (!file.is_open())
+		return false;
+
+	std::vector<char> data((size_t)file.tellg());
+	file.seekg(0);
+	if (!file.read(data.data(), data.size()))
+		return false;
+
+	file.close();
+
+	LibraryReader reader(data);
+
+	char magic[4];
+	for (int i = 0; i < 4; i++)
+		magic[i] = (char)reader.readByte();
+
+	if (memcmp(magic, LIBRARY_CACHE_MAGIC, 4) != 0 || reader.readInt() != LIBRARY_CACHE_VERSION || reader.readString() != sources->signature)
+		return false;
+
+	LibrarySources cached;
+	cached.signature = sources->signature;
+	cached.gamelist = reader.readStamp();
+
+	unsigned int folderCount = reader.readInt();
+	for (unsigned int i = 0; i < folderCount && reader.isValid(); i++)
+		cached.folders.push_back(reader.readStamp());
+
+	if (!reader.isValid() || cached.gamelist.path != sources->gamelist.path || !isUpToDate(cached))
+		return false;
+
+	// Nodes are in depth first order : a parent is always read before its children
+	std::string startPath = system->getStartPath();
+	FolderData* root = system->getRootFolder();
+
+	std::vector<FileData*> nodes;
+
+	// A node takes more than 16 bytes : don't trust a count which doesn't fit in the file
+	unsigned int nodeCount = reader.readInt();
+	nodes.reserve(std::min((size_t)nodeCount, data.size() / 16));
+
+	for (unsigned int i = 0; i < nodeCount && reader.isValid(); i++)
+	{
+		FileType type = (FileType)reader.readByte();
+		unsigned int parentIndex = reader.readInt();
+		bool relative = reader.readByte() != 0;
+		std::string nodePath = reader.readString();
+
+		FileData* node = nullptr;
+
+		if (i == 0)
+			node = root;
+		else if (parentIndex < nodes.size() && nodes[parentIndex]->getType() == FOLDER && (type == GAME || type == FOLDER))
+		{
+			if (relative)
+				nodePath = startPath + "/" + nodePath;
+
+			if (type == FOLDER)
+				node = new FolderData(nodePath, system);
+			else
+				node = new FileData(GAME, nodePath, system);
+
+			((FolderData*)nodes[parentIndex])->addChild(node);
+			fileMap[nodePath] = node;
+		}
+		else
+			break;
+
+		MetaDataList& mdl = node->getMetadata();
+		mdl.mType = (MetaDataListType)reader.readByte();
+		mdl.mRelativeTo = reader.readByte() != 0 ? system : nullptr;
+		mdl.mName = reader.readString();
+
+		mdl.mPresent = 0;
+		mdl.mInStrings = 0;
+		mdl.mStrings.clear();
+
+		unsigned int count = reader.readInt();
+		for (unsigned int v = 0; v < count && reader.isValid(); v++)
+		{
+			int id = (int)reader.readByte();
+			std::string value = reader.readString();
+
+			if (id > 0 && id < MetaDataList::SLOT_COUNT)
+				mdl.setRaw((MetaDataId)id, value);
+		}
+
+		mdl.mScrapeDates.clear();
+		count = reader.readInt();
+		for (unsigned int v = 0; v < count && reader.isValid(); v++)
+		{
+			int scraper = (int)reader.readByte();
+			mdl.mScrapeDates.push_back(std::make_pair(scraper, Utils::Time::DateTime((time_t)reader.readLong())));
+		}
+
+		mdl.mUnKnownElements.clear();
+		count = reader.readInt();
+		for (unsigned int v = 0; v < count && reader.isValid(); v++)
+		{
+			std::string name = reader.readString();
+			std::string value = reader.readString();
+			bool isElement = reader.readByte() != 0;
+			mdl.mUnKnownElements.push_back(std::tuple<std::string, std::string, bool>(name, value, isElement));
+		}
+
+		mdl.resetChangedFlag();
+		nodes.push_back(node);
+	}
+
+	if (!reader.isValid() || nodes.size() != nodeCount)
+	{
+		LOG(LogWarning) << "LibraryCache : " << path << " is corrupted";
+
+		// Deleting the top level nodes deletes their children
+		for (auto child : std::vector<FileData*>(root->getChildren()))
+			delete child;
+
+		for (auto it = fileMap.begin(); it != fileMap.end(); )
+		{
+			if (it->second != root)
+				it = fileMap.erase(it);
+			else
+				++it;
+		}
+
+		root->getMetadata().set(MetaDataId::Name, system->getFullName());
+		root->getMetadata().resetChangedFlag();
+		return false;
+	}
+
+	*sources = cached;
+	system->setGamelistHash((size_t)cached.gamelist.size);
+
+	LOG(LogInfo) << "LibraryCache : " << system->getName() << " loaded from " << path;
+	return true;
+}
+
+bool LibraryCache::canSave(SystemData* system)
+{
+	// Grouped systems only hold the games of other systems
+	LibrarySources* sources = system->mLibrarySources;
+	if (sources == nullptr || system->mIsGroupSystem || !isEnabled())
+		return false;
+
+	// Unsaved changes would be loaded back from the snapshot
+	if (!Settings::SaveGamelistsOnExit() && hasDirtyFile(system))
+		return false;
+
+	// Files added or removed while running, gamelist rewritten by a scraper...
+	return isUpToDate(*sources);
+}
+
+void LibraryCache::updateGamelistStamp(SystemData* system)
+{
+	if (system->mLibrarySources != nullptr)
+		stampFile(system->mLibrarySources->gamelist, system->getGamelistPath(false));
+}
+
+void LibraryCache::save(SystemData* system)
+{
+	LibrarySources* sources = system->mLibrarySources;
+	if (sources == nullptr)
+		return;
+
+	std::string startPath = system->getStartPath();
+	std::string relativeRoot = startPath + "/";
+
+	LibraryWriter writer;
+
+	for (int i = 0; i < 4; i++)
+		writer.writeByte((unsigned char)LIBRARY_CACHE_MAGIC[i]);
+
+	writer.writeInt(LIBRARY_CACHE_VERSION);
+	writer.writeString(sources->signature);
+	writer.writeStamp(sources->gamelist);
+
+	writer.writeInt((unsigned int)sources->folders.size());
+	for (const auto& folder : sources->folders)
+		writer.writeStamp(folder);
+
+	std::vector<std::pair<FileData*, unsigned int>> nodes;
+
+	std::stack<std::pair<FileData*, unsigned int>> stack;
+	stack.push(std::make_pair((FileData*)system->getRootFolder(), 0));
+
+	while (stack.size())
+	{
+		auto item = stack.top();
+		stack.pop();
+
+		unsigned int index = (unsigned int)nodes.size();
+		nodes.push_back(item);
+
+		if (item.first->getType() != FOLDER)
+			continue;
+
+		// Pushed backwards : children are written in their current order
+		auto& children = ((FolderData*)item.first)->getChildren();
+		for (auto it = children.crbegin(); it != children.crend(); ++it)
+			if ((*it)->getSystem() == system && ((*it)->getType() == GAME || (*it)->getType() == FOLDER))
+				stack.push(std::make_pair(*it, index));
+	}
+
+	writer.writeInt((unsigned int)nodes.size());
+
+	for (auto node : nodes)
+	{
+		FileData* file = node.first;
+		std::string path = file->getPath();
+
+		bool relative = Utils::String::startsWith(path, relativeRoot);
+		if (relative)
+			path = path.substr(relativeRoot.size());
+
+		writer.writeByte((unsigned char)file->getType());
+		writer.writeInt(node.second);
+		writer.writeByte(relative ? 1 : 0);
+		writer.writeString(path);
+
+		const MetaDataList& mdl = file->getMetadata();
+		writer.writeByte((unsigned char)mdl.mType);
+		writer.writeByte(mdl.mRelativeTo != nullptr ? 1 : 0);
+		writer.writeString(mdl.mName);
+
+		std::vector<MetaDataId> ids;
+		for (int id = 1; id < MetaDataList::SLOT_COUNT; id++)
+			if (mdl.hasValue((MetaDataId)id))
+				ids.push_back((MetaDataId)id);
+
+		writer.writeInt((unsigned int)ids.size());
+		for (auto id : ids)
+		{
+			writer.writeByte((unsigned char)id);
+			writer.writeString(mdl.getRaw(id));
+		}
+
+		writer.writeInt((unsigned int)mdl.mScrapeDates.size());
+		for (const auto& date : mdl.mScrapeDates)
+		{
+			writer.writeByte((unsigned char)date.first);
+			writer.writeLong((long long)date.second.getTime());
+		}
+
+		writer.writeInt((unsigned int)mdl.mUnKnownElements.size());
+		for (const auto& element : mdl.mUnKnownElements)
+		{
+			writer.writeString(std::get<0>(element));
+			writer.writeString(std::get<1>(element));
+			writer.writeByte(std::get<2>(element) ? 1 : 0);
+		}
+	}
+
+	std::string path = getCachePath(system);
+	std::string tmpPath = path + ".tmp";
+
+	Utils::FileSystem::createDirectory(Utils::FileSystem::getParent(path));
+
+	// Written aside then renamed : an interrupted write never leaves a truncated snapshot
+	std::ofstream file(WINSTRINGW(tmpPath), std::ios::binary | std::ios::trunc);
+	if (!file.is_open())
+	{
+		LOG(LogError) << "LibraryCache : Unable to write " << tmpPath;
+		return;
+	}
+
+	file.write(writer.data().c_str(), writer.data().size());
+	file.close();
+
+	if (file.fail())
+	{
+		LOG(LogError) << "LibraryCache : Unable to write " << tmpPath;
+		Utils::FileSystem::removeFile(tmpPath);
+		return;
+	}
+
+	Utils::FileSystem::removeFile(path);
+	Utils::FileSystem::renameFile(tmpPath, path);
+}
@@ -0,0 +1,57 @@
+#pragma once
+#ifndef ES_APP_LIBRARY_CACHE_H
+#define ES_APP_LIBRARY_CACHE_H
+
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+class SystemData;
+class FileData;
+
+// What the games of a system were loaded from : rom folders and gamelist.xml, with their modification times.
+struct LibrarySources
+{
+	struct Stamp
+	{
+		std::string path;
+		long long time;
+		unsigned long long size;
+	};
+
+	// Settings and system configuration which change the result of the loading
+	std::string signature;
+
+	Stamp gamelist;
+	std::vector<Stamp> folders;
+};
+
+// Binary snapshot of the games of each system (FileData tree & metadata), in ~/.emulationstation/cache/library/<system>.bin.
+// Snapshots are written when the systems are deleted, and a system loads from its snapshot instead of scanning its rom folders
+// and parsing its gamelist.xml when none of its sources changed since.
+class LibraryCache
+{
+public:
+	static bool isEnabled();
+
+	// Fills system->mLibrarySources with the current sources. Returns true if the tree was loaded from the snapshot :
+	// otherwise the caller loads the system as usual, and populateFolder adds the folders it scans.
+	static bool load(SystemData* system, std::unordered_map<std::string, FileData*>& fileMap);
+
+	// To call before the gamelist is saved at exit : false if the tree can't be written (sources changed by another program...)
+	static bool canSave(SystemData* system);
+	static void save(SystemData* system);
+
+	// Called when ES itself rewrote the gamelist : its new date is not a change of the sources
+	static void updateGamelistStamp(SystemData* system);
+
+	static void stampFolder(LibrarySources::Stamp& stamp, const std::string& path);
+
+private:
+	static std::string getCachePath(SystemData* system);
+	static std::string getSignature(SystemData* system);
+	static void stampFile(LibrarySources::Stamp& stamp, const std::string& path);
+	static bool isUpToDate(const LibrarySources& sources);
+};
+
+#endif // ES_APP_LIBRARY_CACHE_H
@@ -9,14 +9,218 @@
 #include "Settings.h"
 #include "FileData.h"
 #include "ImageIO.h"
+#include <algorithm>
+#include <mutex>
+#include <unordered_map>
 
 std::vector<MetaDataDecl> MetaDataList::mMetaDataDecls;
+MetaDataList::SlotKind MetaDataList::mSlotKinds[MetaDataList::SLOT_COUNT];
+
+static_assert(MetaDataId::Bezel < 64, "MetaDataList uses one bit per MetaDataId");
 
 static std::map<MetaDataId, int> mMetaDataIndexes;
 static std::string* mDefaultGameMap = nullptr;
 static MetaDataType* mGameTypeMap = nullptr;
 static std::map<std::string, MetaDataId> mGameIdMap;
 
+// Values shared by many games (genres, developers, "true"...) are stored once for the whole library.
+// Strings are never removed and never move : reading one by its id doesn't need the lock.
+class MetaDataStringPool
+{
+public:
+	static bool intern(const std::string& value, std::uint32_t& id)
+	{
+		std::unique_lock<std::mutex> lock(mMutex);
+
+		auto it = mIds.find(value);
+		if (it != mIds.cend())
+		{
+			id = it->second;
+			return true;
+		}
+
+		size_t chunk = mCount / CHUNK_SIZE;
+		if (chunk >= MAX_CHUNKS)
+			return false;
+
+		if (mChunks[chunk] == nullptr)
+			mChunks[chunk] = new std::string[CHUNK_SIZE];
+
+		id = mCount++;
+		mChunks[chunk][id % CHUNK_SIZE] = value;
+		mIds[value] = id;
+		return true;
+	}
+
+	static inline const std::string& get(std::uint32_t id) { return mChunks[id / CHUNK_SIZE][id % CHUNK_SIZE]; }
+
+private:
+	static const size_t CHUNK_SIZE = 1024;
+	static const size_t MAX_CHUNKS = 4096;
+
+	static std::mutex mMutex;
+	static std::unordered_map<std::string, std::uint32_t> mIds;
+	static std::string* mChunks[MAX_CHUNKS];
+	static std::uint32_t mCount;
+};
+
+std::mutex MetaDataStringPool::mMutex;
+std::unordered_map<std::string, std::uint32_t> MetaDataStringPool::mIds;
+std::string* MetaDataStringPool::mChunks[MetaDataStringPool::MAX_CHUNKS];
+std::uint32_t MetaDataStringPool::mCount = 0;
+
+// Decimal numbers (ratings) are stored in millionths
+static std::string formatDecimal(std::uint32_t value)
+{
+	std::string ret = std::to_string(value / 1000000);
+
+	std::uint32_t decimals = value % 1000000;
+	if (decimals == 0)
+		return ret;
+
+	char buffer[8];
+	snprintf(buffer, sizeof(buffer), "%06u", decimals);
+
+	std::string digits(buffer);
+	while (digits.back() == '0')
+		digits.pop_back();
+
+	return ret + "." + digits;
+}
+
+// The parse functions return false if 'value' would not be formatted back the same
+static bool parseDecimal(const std::string& value, std::uint32_t& ret)
+{
+	if (value.empty() || value.size() > 11)
+		return false;
+
+	std::uint64_t number = 0;
+	std::uint64_t scale = 1000000;
+	bool decimals = false;
+
+	for (auto c : value)
+	{
+		if (c == '.' && !decimals)
+			decimals = true;
+		else if (c < '0' || c > '9')
+			return false;
+		else if (!decimals)
+			number = number * 10 + (c - '0');
+		else if (scale > 1)
+		{
+			scale /= 10;
+			number = number * 10 + (c - '0');
+		}
+		else
+			return false;
+	}
+
+	number *= scale;
+	if (number > UINT32_MAX)
+		return false;
+
+	ret = (std::uint32_t)number;
+	return formatDecimal(ret) == value;
+}
+
+static bool parseInt(const std::string& value, std::uint32_t& ret)
+{
+	if (value.empty() || value.size() > 11)
+		return false;
+
+	char* end = nullptr;
+	long long number = strtoll(value.c_str(), &end, 10);
+	if (*end != 0 || number < INT32_MIN || number > INT32_MAX)
+		return false;
+
+	ret = (std::uint32_t)(std::int32_t)number;
+	return std::to_string((std::int32_t)ret) == value;
+}
+
+// Days between 1970-01-01 and a date of the proleptic gregorian calendar
+static long long daysFromCivil(int year, int month, int day)
+{
+	year -= month <= 2;
+	long long era = (year >= 0 ? year : year - 399) / 400;
+	int yoe = year - (int)(era * 400);
+	int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+	int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+	return era * 146097 + doe - 719468;
+}
+
+static void civilFromDays(long long days, int& year, int& month, int& day)
+{
+	days += 719468;
+	long long era = (days >= 0 ? days : days - 146096) / 146097;
+	int doe = (int)(days - era * 146097);
+	int yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+	int doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+	int mp = (5 * doy + 2) / 153;
+
+	day = doy - (153 * mp + 2) / 5 + 1;
+	month = mp + (mp < 10 ? 3 : -9);
+	year = yoe + (int)(era * 400) + (month <= 2);
+}
+
+static int parseDigits(const char* s, int count)
+{
+	int ret = 0;
+
+	for (int i = 0; i < count; i++)
+	{
+		if (s[i] < '0' || s[i] > '9')
+			return -1;
+
+		ret = ret * 10 + (s[i] - '0');
+	}
+
+	return ret;
+}
+
+// ISO dates (YYYYMMDDTHHMMSS) kept as seconds since 1970-01-01T000000 of the same calendar, without any time zone
+// conversion : they are packed & formatted without the C library time functions, and dates before 1970 stay strings.
+static bool parseTime(const std::string& value, std::uint32_t& ret)
+{
+	if (value.size() != 15 || value[8] != 'T')
+		return false;
+
+	const char* s = value.c_str();
+
+	int year = parseDigits(s, 4);
+	int month = parseDigits(s + 4, 2);
+	int day = parseDigits(s + 6, 2);
+	int hour = parseDigits(s + 9, 2);
+	int minute = parseDigits(s + 11, 2);
+	int second = parseDigits(s + 13, 2);
+
+	if (year < 1970 || month < 1 || month > 12 || day < 1 || hour < 0 || hour > 23 || minute < 0 || minute > 59 || second < 0 || second > 59)
+		return false;
+
+	static const int daysInMonth[] = { 31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31 };
+	bool leapYear = (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+	if (day > daysInMonth[month - 1] + (month == 2 && leapYear ? 1 : 0))
+		return false;
+
+	long long time = daysFromCivil(year, month, day) * 86400 + hour * 3600 + minute * 60 + second;
+	if (time > UINT32_MAX)
+		return false;
+
+	ret = (std::uint32_t)time;
+	return true;
+}
+
+static std::string formatTime(std::uint32_t time)
+{
+	int year, month, day;
+	civilFromDays(time / 86400, year, month, day);
+
+	int seconds = time % 86400;
+
+	char buffer[32];
+	snprintf(buffer, sizeof(buffer), "%04d%02d%02dT%02d%02d%02d", year, month, day, seconds / 3600, (seconds / 60) % 60, seconds % 60);
+	return buffer;
+}
+
 static std::map<std::string, int> KnowScrapersIds =
 {
 	{ "ScreenScraper", 0 },
@@ -123,6 +327,19 @@ void MetaDataList::initMetadata()
 		mGameTypeMap[iter->id] = iter->type;
 		mGameIdMap[iter->key] = iter->id;
 	}
+
+	for (int i = 0; i < SLOT_COUNT; i++)
+		mSlotKinds[i] = i < maxID && mGameTypeMap[i] == MD_BOOL ? SLOT_INTERNED : SLOT_STRING;
+
+	// Few different values in the whole library
+	for (auto id : { Genre, GenreIds, Family, Developer, Publisher, Region, Language, Emulator, Core, Players, ArcadeSystemName })
+		mSlotKinds[id] = SLOT_INTERNED;
+
+	mSlotKinds[Rating] = SLOT_DECIMAL;
+	mSlotKinds[PlayCount] = SLOT_INT;
+	mSlotKinds[GameTime] = SLOT_INT;
+	mSlotKinds[ReleaseDate] = SLOT_TIME;
+	mSlotKinds[LastPlayed] = SLOT_TIME;
 }
 
 MetaDataType MetaDataList::getType(MetaDataId id) const
@@ -140,7 +357,7 @@ MetaDataId MetaDataList::getId(const std::string& key) const
 	return mGameIdMap[key];
 }
 
-MetaDataList::MetaDataList(MetaDataListType type) : mType(type), mWasChanged(false), mRelativeTo(nullptr)
+MetaDataList::MetaDataList(MetaDataListType type) : mType(type), mWasChanged(false), mVersion(0), mRelativeTo(nullptr), mPresent(0), mInStrings(0)
 {
 
 }
@@ -149,6 +366,7 @@ void MetaDataList::loadFromXML(MetaDataListType type, pugi::xml_node& node, Syst
 {
 	mType = type;
 	mRelativeTo = system;	
+	mVersion++;
 
 	mUnKnownElements.clear();
 	mScrapeDates.clear();
@@ -176,7 +394,13 @@ void MetaDataList::loadFromXML(MetaDataListType type, pugi::xml_node& node, Syst
 				if (!dateTime.isValid())
 					continue;
 								
-				mScrapeDates[scraperId->second] = dateTime;
+				int id = scraperId->second;
+
+				auto it = std::find_if(mScrapeDates.begin(), mScrapeDates.end(), [id](const std::pair<int, Utils::Time::DateTime>& date) { return date.first == id; });
+				if (it != mScrapeDates.end())
+					it->second = dateTime;
+				else
+					mScrapeDates.push_back(std::make_pair(id, dateTime));
 			}		
 								
 			continue;
@@ -290,16 +514,15 @@ void MetaDataList::appendToXML(pugi::xml_node& parent, bool ignoreDefaults, cons
 		if (mddIter->id == MetaDataId::GenreIds)
 			continue;
 
-		auto mapIter = mMap.find(mddIter->id);
-		if(mapIter != mMap.cend())
+		if (hasValue(mddIter->id))
 		{
 			// we have this value!
 			// if it's just the default (and we ignore defaults), don't write it
-			if (ignoreDefaults && mapIter->second == mddIter->defaultValue)
+			std::string value = getRaw(mddIter->id);
+			if (ignoreDefaults && value == mddIter->defaultValue)
 				continue;
 
 			// try and make paths relative if we can
-			std::string value = mapIter->second;
 			if (mddIter->type == MD_PATH)
 			{
 				if (fullPaths && mRelativeTo != nullptr)
@@ -326,7 +549,10 @@ void MetaDataList::appendToXML(pugi::xml_node& parent, bool ignoreDefaults, cons
 
 	if (mScrapeDates.size() > 0)
 	{
-		for (auto scrapeDate : mScrapeDates)
+		auto scrapeDates = mScrapeDates;
+		std::sort(scrapeDates.begin(), scrapeDates.end(), [](const std::pair<int, Utils::Time::DateTime>& a, const std::pair<int, Utils::Time::DateTime>& b) { return a.first < b.first; });
+
+		for (auto scrapeDate : scrapeDates)
 		{
 			std::string name;
 
@@ -358,6 +584,7 @@ void MetaDataList::set(MetaDataId id, const std::string& value)
 
 		mName = value;
 		mWasChanged = true;
+		mVersion++;
 		return;
 	}
 
@@ -368,16 +595,16 @@ void MetaDataList::set(MetaDataId id, const std::string& value)
 	// 	return;
 	// }
 
-	auto prev = mMap.find(id);
-	if (prev != mMap.cend() && prev->second == value)
+	if (hasValue(id) && getRaw(id) == value)
 		return;
 
 	if (mGameTypeMap[id] == MD_PATH && mRelativeTo != nullptr) // if it's a path, resolve relative paths				
-		mMap[id] = Utils::FileSystem::createRelativePath(value, mRelativeTo->getStartPath(), true);
+		setRaw(id, Utils::FileSystem::createRelativePath(value, mRelativeTo->getStartPath(), true));
 	else
-		mMap[id] = Utils::String::trim(value);
+		setRaw(id, Utils::String::trim(value));
 
 	mWasChanged = true;
+	mVersion++;
 }
 
 const std::string MetaDataList::get(MetaDataId id, bool resolveRelativePaths) const
@@ -385,18 +612,109 @@ const std::string MetaDataList::get(MetaDataId id, bool resolveRelativePaths) co
 	if (id == MetaDataId::Name)
 		return mName;
 
-	auto it = mMap.find(id);
-	if (it != mMap.end())
+	if (hasValue(id))
 	{
 		if (resolveRelativePaths && mGameTypeMap[id] == MD_PATH && mRelativeTo != nullptr) // if it's a path, resolve relative paths				
-			return Utils::FileSystem::resolveRelativePath(it->second, mRelativeTo->getStartPath(), true);
+			return Utils::FileSystem::resolveRelativePath(getRaw(id), mRelativeTo->getStartPath(), true);
 
-		return it->second;
+		return getRaw(id);
 	}
 
 	return mDefaultGameMap[id];
 }
 
+const std::string MetaDataList::getRaw(MetaDataId id) const
+{
+	std::uint32_t slot = mSlots[id];
+
+	if (mInStrings & (1ULL << id))
+		return mStrings[slot];
+
+	switch (mSlotKinds[id])
+	{
+	case SLOT_INTERNED:
+		return MetaDataStringPool::get(slot);
+	case SLOT_INT:
+		return std::to_string((std::int32_t)slot);
+	case SLOT_DECIMAL:
+		return formatDecimal(slot);
+	case SLOT_TIME:
+		return formatTime(slot);
+	default:
+		return mStrings[slot];
+	}
+}
+
+void MetaDataList::setRaw(MetaDataId id, const std::string& value)
+{
+	std::uint32_t slot = 0;
+
+	switch (mSlotKinds[id])
+	{
+	case SLOT_INTERNED:
+		if (MetaDataStringPool::intern(value, slot))
+		{
+			setSlot(id, slot);
+			return;
+		}
+		break;
+	case SLOT_INT:
+		if (parseInt(value, slot))
+		{
+			setSlot(id, slot);
+			return;
+		}
+		break;
+	case SLOT_DECIMAL:
+		if (parseDecimal(value, slot))
+		{
+			setSlot(id, slot);
+			return;
+		}
+		break;
+	case SLOT_TIME:
+		if (parseTime(value, slot))
+		{
+			setSlot(id, slot);
+			return;
+		}
+		break;
+	default:
+		break;
+	}
+
+	std::uint64_t bit = 1ULL << id;
+
+	if ((mPresent & bit) && (mInStrings & bit))
+		mStrings[mSlots[id]] = value;
+	else
+	{
+		mSlots[id] = (std::uint32_t)mStrings.size();
+		mStrings.push_back(value);
+	}
+
+	mPresent |= bit;
+	mInStrings |= bit;
+}
+
+void MetaDataList::setSlot(MetaDataId id, std::uint32_t value)
+{
+	std::uint64_t bit = 1ULL << id;
+
+	// The value was kept as a string until now
+	if ((mPresent & bit) && (mInStrings & bit))
+	{
+		if (mSlots[id] + 1 == mStrings.size())
+			mStrings.pop_back();
+		else
+			std::string().swap(mStrings[mSlots[id]]);
+	}
+
+	mSlots[id] = value;
+	mPresent |= bit;
+	mInStrings &= ~bit;
+}
+
 void MetaDataList::set(const std::string& key, const std::string& value)
 {
 	if (mGameIdMap.find(key) == mGameIdMap.cend())
@@ -420,14 +738,30 @@ const std::string MetaDataList::get(const std::string& key, bool resolveRelative
 
 int MetaDataList::getInt(MetaDataId id) const
 {
+	if (mSlotKinds[id] == SLOT_INT && hasValue(id) && !(mInStrings & (1ULL << id)))
+		return (std::int32_t)mSlots[id];
+
 	return atoi(get(id).c_str());
 }
 
 float MetaDataList::getFloat(MetaDataId id) const
 {
+	if (mSlotKinds[id] == SLOT_DECIMAL && hasValue(id) && !(mInStrings & (1ULL << id)))
+		return mSlots[id] / 1000000.0f;
+
 	return Utils::String::toFloat(get(id));
 }
 
+bool MetaDataList::isLess(MetaDataId id, const MetaDataList& other) const
+{
+	// ISO dates sort like the times they represent
+	std::uint64_t bit = 1ULL << id;
+	if (mSlotKinds[id] == SLOT_TIME && (mPresent & other.mPresent & bit) && !((mInStrings | other.mInStrings) & bit))
+		return mSlots[id] < other.mSlots[id];
+
+	return get(id) < other.get(id);
+}
+
 bool MetaDataList::wasChanged() const
 {
 	return mWasChanged;
@@ -567,7 +901,14 @@ void MetaDataList::setScrapeDate(const std::string& scraper)
 	if (it == KnowScrapersIds.cend())
 		return;
 
-	mScrapeDates[it->second] = Utils::Time::DateTime::now();
+	int scraperId = it->second;
+
+	auto date = std::find_if(mScrapeDates.begin(), mScrapeDates.end(), [scraperId](const std::pair<int, Utils::Time::DateTime>& date) { return date.first == scraperId; });
+	if (date != mScrapeDates.end())
+		date->second = Utils::Time::DateTime::now();
+	else
+		mScrapeDates.push_back(std::make_pair(scraperId, Utils::Time::DateTime::now()));
+
 	mWasChanged = true;
 }
 
@@ -576,9 +917,9 @@ Utils::Time::DateTime* MetaDataList::getScrapeDate(const std::string& scraper)
 	auto it = KnowScrapersIds.find(scraper);
 	if (it != KnowScrapersIds.cend())
 	{
-		auto itd = mScrapeDates.find(it->second);
-		if (itd != mScrapeDates.cend())
-			return &itd->second;
+		for (auto& date : mScrapeDates)
+			if (date.first == it->second)
+				return &date.second;
 	}
 
 	return nullptr;
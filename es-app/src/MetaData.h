@@ -6,6 +6,7 @@
 #include <vector>
 #include <functional>
 #include <string>
+#include <cstdint>
 
 #include "utils/TimeUtil.h"
 
@@ -76,6 +77,8 @@ enum MetaDataId
 	GenreIds = 39,
 	Family = 40,
 	Bezel = 41
+
+	// MetaDataList::SLOT_COUNT must follow the last id
 };
 
 namespace MetaDataImportType
@@ -131,6 +134,9 @@ enum MetaDataListType
 
 class MetaDataList
 {
+	friend class LibraryCache;
+	friend class FileData;
+
 public:
 	static void initMetadata();
 
@@ -151,6 +157,9 @@ public:
 	int getInt(MetaDataId id) const;
 	float getFloat(MetaDataId id) const;
 
+	// Same order as comparing the get(id) strings, without formatting the dates stored as numbers
+	bool isLess(MetaDataId id, const MetaDataList& other) const;
+
 	MetaDataType getType(MetaDataId id) const;
 	MetaDataType getType(const std::string name) const;
 
@@ -158,6 +167,9 @@ public:
 
 	bool wasChanged() const;
 	void resetChangedFlag();
+
+	// Incremented when a value changes, unlike the changed flag it is never reset : tells if data computed from the values is outdated
+	inline unsigned int getVersion() const { return mVersion; }
 	const void setDirty() 
 	{ 
 		mWasChanged = true; 
@@ -177,14 +189,39 @@ public:
 	Utils::Time::DateTime* getScrapeDate(const std::string& scraper);
 
 private:
-	std::map<int, Utils::Time::DateTime> mScrapeDates;
+	static const int SLOT_COUNT = MetaDataId::Bezel + 1;
+
+	enum SlotKind : unsigned char
+	{
+		SLOT_STRING,	// index in mStrings
+		SLOT_INTERNED,	// id in the string pool shared by all the games
+		SLOT_INT,		// the value itself...
+		SLOT_DECIMAL,	// ...in millionths
+		SLOT_TIME		// ...as a time_t
+	};
+
+	inline bool hasValue(MetaDataId id) const { return (mPresent & (1ULL << id)) != 0; }
 
+	// Value as stored, relative paths are not resolved
+	const std::string getRaw(MetaDataId id) const;
+	void setRaw(MetaDataId id, const std::string& value);
+	void setSlot(MetaDataId id, std::uint32_t value);
+
+	std::vector<std::pair<int, Utils::Time::DateTime>> mScrapeDates;
 	std::string		mName;
 	MetaDataListType mType;
-	std::map<MetaDataId, std::string> mMap;
 	bool mWasChanged;
+	unsigned int mVersion;
 	SystemData*		mRelativeTo;
 
+	// One slot per MetaDataId, used when its bit is set in mPresent. Values which don't fit their slot kind
+	// (a number with another format...) are kept as is in mStrings, with their bit set in mInStrings.
+	std::uint64_t mPresent;
+	std::uint64_t mInStrings;
+	std::uint32_t mSlots[SLOT_COUNT];
+	std::vector<std::string> mStrings;
+
+	static SlotKind mSlotKinds[SLOT_COUNT];
 	static std::vector<MetaDataDecl> mMetaDataDecls;
 
 	std::vector<std::tuple<std::string, std::string, bool>> mUnKnownElements;
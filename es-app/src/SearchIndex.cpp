@@ -0,0 +1,497 @@
+#include "SearchIndex.h"
+
+#include "utils/StringUtil.h"
+#include "FileData.h"
+
+#include <algorithm>
+
+static std::vector<FileData*> EMPTY_POSTINGS;
+
+static float jw_distance(std::string s1, std::string s2, bool caseSensitive = true) {
+	float m = 0;
+	int low, high, range;
+	int k = 0, numTrans = 0;
+
+	// Exit early if either are empty
+	if (s1.length() == 0 || s2.length() == 0) {
+		return 0;
+	}
+
+	// Convert to lower if case-sensitive is false
+	if (caseSensitive == false) {
+		transform(s1.begin(), s1.end(), s1.begin(), ::tolower);
+		transform(s2.begin(), s2.end(), s2.begin(), ::tolower);
+	}
+
+	// Exit early if they're an exact match.
+	if (s1 == s2) {
+		return 1;
+	}
+
+	range = (std::max(s1.length(), s2.length()) / 2) - 1;
+	int s1Matches[65000] = {};
+	int s2Matches[65000] = {};
+
+	for (int i = 0; i < s1.length(); i++) {
+
+		// Low Value;
+		if (i >= range) {
+			low = i - range;
+		}
+		else {
+			low = 0;
+		}
+
+		// High Value;
+		if (i + range <= (s2.length() - 1)) {
+			high = i + range;
+		}
+		else {
+			high = s2.length() - 1;
+		}
+
+		for (int j = low; j <= high; j++) {
+			if (s1Matches[i] != 1 && s2Matches[j] != 1 && s1[i] == s2[j]) {
+				m += 1;
+				s1Matches[i] = 1;
+				s2Matches[j] = 1;
+				break;
+			}
+		}
+	}
+
+	// Exit early if no matches were found
+	if (m == 0) {
+		return 0;
+	}
+
+	// Count the transpositions.
+	for (int i = 0; i < s1.length(); i++) {
+		if (s1Matches[i] == 1) {
+			int j;
+			for (j = k; j < s2.length(); j++) {
+				if (s2Matches[j] == 1) {
+					k = j + 1;
+					break;
+				}
+			}
+
+			if (s1[i] != s2[j]) {
+				numTrans += 1;
+			}
+		}
+	}
+
+	float weight = (m / s1.length() + m / s2.length() + (m - (numTrans / 2)) / m) / 3;
+	float l = 0;
+	float p = 0.1;
+	if (weight > 0.7) {
+		while (s1[l] == s2[l] && l < 4) {
+			l += 1;
+		}
+
+		weight += l * p * (1 - weight);
+	}
+	return weight;
+}
+
+static std::vector<std::string> getWords(const std::string& text)
+{
+	auto s = Utils::String::toLower(text);
+	s = Utils::String::replace(s, ":", "");
+	s = Utils::String::replace(s, ".", "");
+	s = Utils::String::replace(s, " - ", " ");
+	s = Utils::String::replace(s, "- ", " ");
+
+	std::vector<std::string> ret;
+
+	for (auto v : Utils::String::split(s, ' '))
+	{
+		if (v.empty() || v.length() <= 2 || v == "and" || v == "not" || v == "for" || v == "the" || v == "les" || v == "des")
+			continue;
+
+		ret.push_back(v);
+	}
+
+	return ret;
+}
+
+static void getTrigrams(const std::string& folded, std::vector<unsigned int>& trigrams)
+{
+	trigrams.clear();
+
+	for (size_t i = 0; i + 2 < folded.size(); i++)
+		trigrams.push_back(((unsigned char)folded[i] << 16) | ((unsigned char)folded[i + 1] << 8) | (unsigned char)folded[i + 2]);
+
+	std::sort(trigrams.begin(), trigrams.end());
+	trigrams.erase(std::unique(trigrams.begin(), trigrams.end()), trigrams.end());
+}
+
+static void removePosting(std::vector<FileData*>& postings, FileData* game)
+{
+	auto it = std::find(postings.begin(), postings.end(), game);
+	if (it == postings.end())
+		return;
+
+	std::iter_swap(it, postings.end() - 1);
+	postings.pop_back();
+}
+
+SearchIndex::SearchIndex() : mHasPostings(false)
+{
+
+}
+
+SearchIndex::Query SearchIndex::createQuery(const std::string& text, bool useRelevancy, bool usePinyin)
+{
+	Query query;
+	query.text = text;
+	query.useRelevancy = useRelevancy;
+	query.usePinyin = usePinyin && !useRelevancy;
+	query.folded = Utils::String::toLower(text);
+
+	if (useRelevancy)
+	{
+		query.tokens.push_back(query.folded);
+
+		if (text.find(' ') != std::string::npos)
+			query.words = getWords(text);
+	}
+	else if (text.find(',') == std::string::npos)
+		query.tokens.push_back(query.folded);
+	else
+	{
+		for (auto token : Utils::String::split(text, ',', true))
+			query.tokens.push_back(Utils::String::toLower(Utils::String::trim(token)));
+	}
+
+	return query;
+}
+
+void SearchIndex::createEntry(FileData* game, Entry& entry)
+{
+	entry.name = game->getSourceFileData()->getName();
+	entry.folded = Utils::String::toLower(entry.name);
+	entry.words = getWords(entry.name);
+	entry.pinyin = Utils::String::getPinyinInitials(entry.name);
+	entry.version = game->getMetadata().getVersion();
+}
+
+void SearchIndex::add(FileData* game)
+{
+	auto it = mEntries.find(game);
+	if (it != mEntries.cend())
+		remove(game);
+
+	Entry& entry = mEntries[game];
+	createEntry(game, entry);
+
+	if (!entry.pinyin.empty())
+		mPinyinGames.insert(game);
+
+	if (mHasPostings)
+		addPostings(game, entry);
+}
+
+void SearchIndex::remove(FileData* game)
+{
+	auto it = mEntries.find(game);
+	if (it == mEntries.cend())
+		return;
+
+	if (mHasPostings)
+		removePostings(game, it->second);
+
+	mPinyinGames.erase(game);
+	mEntries.erase(it);
+}
+
+bool SearchIndex::isUpToDate(FileData* game) const
+{
+	auto it = mEntries.find(game);
+	if (it == mEntries.cend())
+		return true;
+
+	return it->second.version == game->getMetadata().getVersion();
+}
+
+void SearchIndex::update(FileData* game)
+{
+	auto it = mEntries.find(game);
+	if (it == mEntries.cend() || it->second.version == game->getMetadata().getVersion())
+		return;
+
+	Entry& entry = it->second;
+
+	if (mHasPostings)
+		removePostings(game, entry);
+
+	mPinyinGames.erase(game);
+
+	createEntry(game, entry);
+
+	if (!entry.pinyin.empty())
+		mPinyinGames.insert(game);
+
+	if (mHasPostings)
+		addPostings(game, entry);
+}
+
+void SearchIndex::clear()
+{
+	mEntries.clear();
+	mTrigrams.clear();
+	mWords.clear();
+	mPinyinGames.clear();
+	mHasPostings = false;
+}
+
+void SearchIndex::addPostings(FileData* game, const Entry& entry)
+{
+	std::vector<unsigned int> trigrams;
+	getTrigrams(entry.folded, trigrams);
+
+	for (auto trigram : trigrams)
+		mTrigrams[trigram].push_back(game);
+
+	for (auto& word : entry.words)
+	{
+		auto& postings = mWords[word];
+		if (postings.empty() || postings.back() != game)
+			postings.push_back(game);
+	}
+}
+
+void SearchIndex::removePostings(FileData* game, const Entry& entry)
+{
+	std::vector<unsigned int> trigrams;
+	getTrigrams(entry.folded, trigrams);
+
+	for (auto trigram : trigrams)
+	{
+		auto it = mTrigrams.find(trigram);
+		if (it == mTrigrams.cend())
+			continue;
+
+		removePosting(it->second, game);
+		if (it->second.empty())
+			mTrigrams.erase(it);
+	}
+
+	for (auto& word : entry.words)
+	{
+		auto it = mWords.find(word);
+		if (it == mWords.cend())
+			continue;
+
+		removePosting(it->second, game);
+		if (it->second.empty())
+			mWords.erase(it);
+	}
+}
+
+void SearchIndex::buildPostings()
+{
+	for (auto& item : mEntries)
+		addPostings(item.first, item.second);
+
+	mHasPostings = true;
+}
+
+const std::vector<FileData*>* SearchIndex::getCandidates(const std::string& folded)
+{
+	std::vector<unsigned int> trigrams;
+	getTrigrams(folded, trigrams);
+	if (trigrams.empty())
+		return nullptr;
+
+	// Every trigram of the text is in the name of a matching game : the rarest one gives the fewest games to check
+	const std::vector<FileData*>* ret = nullptr;
+
+	for (auto trigram : trigrams)
+	{
+		auto it = mTrigrams.find(trigram);
+		if (it == mTrigrams.cend())
+			return &EMPTY_POSTINGS;
+
+		if (ret == nullptr || it->second.size() < ret->size())
+			ret = &it->second;
+	}
+
+	return ret;
+}
+
+void SearchIndex::search(const Query& query, std::unordered_map<FileData*, int>& scores)
+{
+	scores.clear();
+
+	if (mEntries.empty())
+		return;
+
+	for (auto& item : mEntries)
+		if (item.second.version != item.first->getMetadata().getVersion())
+			update(item.first);
+
+	if (!mHasPostings)
+		buildPostings();
+
+	std::vector<const std::vector<FileData*>*> candidates;
+
+	for (auto& token : query.tokens)
+	{
+		auto postings = getCandidates(token);
+		if (postings == nullptr)
+		{
+			// Text too short to use the postings
+			for (auto& item : mEntries)
+			{
+				int score = getScore(item.second, query);
+				if (score > 0)
+					scores[item.first] = score;
+			}
+
+			return;
+		}
+
+		candidates.push_back(postings);
+	}
+
+	for (auto& word : query.words)
+	{
+		auto it = mWords.find(word);
+		if (it != mWords.cend())
+			candidates.push_back(&it->second);
+	}
+
+	auto checkGame = [this, &query, &scores](FileData* game)
+	{
+		if (scores.find(game) != scores.cend())
+			return;
+
+		auto it = mEntries.find(game);
+		if (it == mEntries.cend())
+			return;
+
+		int score = getScore(it->second, query);
+		if (score > 0)
+			scores[game] = score;
+	};
+
+	for (auto postings : candidates)
+		for (auto game : *postings)
+			checkGame(game);
+
+	if (query.usePinyin)
+		for (auto game : mPinyinGames)
+			checkGame(game);
+}
+
+int SearchIndex::getScore(FileData* game, const Query& query)
+{
+	Entry entry;
+	createEntry(game, entry);
+	return getScore(entry, query);
+}
+
+int SearchIndex::getScore(const Entry& entry, const Query& query)
+{
+	if (!query.useRelevancy)
+	{
+		int textScore = 0;
+
+		for (auto& token : query.tokens)
+		{
+			if (entry.folded.find(token) != std::string::npos)
+				return 1;
+
+			if (query.usePinyin && !entry.pinyin.empty() && Utils::String::containsPinyin(entry.pinyin, token))
+				textScore = 2;
+		}
+
+		return textScore;
+	}
+
+	if (entry.folded == query.folded)
+		return 1;
+
+	if (entry.folded.compare(0, query.folded.size(), query.folded) == 0)
+		return 2;
+
+	if (query.text.find(' ') == std::string::npos)
+		return entry.folded.find(query.folded) != std::string::npos ? 3 : 0;
+
+	auto& filters = query.words;
+	auto& words = entry.words;
+
+	int totalWords = 0;
+	int commonWords = 0;
+
+	for (int i = 0; i < filters.size(); i++)
+	{
+		auto& filter = filters[i];
+
+		for (auto& word : words)
+		{
+			if (word == filter)
+			{
+				commonWords++;
+				break;
+			}
+		}
+
+		totalWords++;
+	}
+
+	if (commonWords == 0)
+		return 0;
+
+	int continuousWords = 0;
+	int maxContinuousWords = 0;
+	int wordsAtStart = 0;
+	bool countStart = true;
+
+	for (int j = 0; j < words.size(); j++)
+	{
+		auto word = words[j];
+
+		for (int i = 0; i < filters.size(); i++)
+		{
+			auto& filter = filters[i];
+
+			if (word == filter)
+			{
+				if (countStart && i == j)
+					wordsAtStart++;
+				else
+					countStart = false;
+
+				continuousWords++;
+
+				if (maxContinuousWords < continuousWords)
+					maxContinuousWords = continuousWords;
+
+				j++;
+
+				if (j < words.size())
+					word = words[j];
+				else
+					break;
+
+				continue;
+			}
+			else
+				countStart = false;
+
+			continuousWords = 0;
+		}
+	}
+
+	if (commonWords > 1 || filters.size() == 1)
+		return 1000 - ((wordsAtStart * 2) + (maxContinuousWords * 3) + commonWords);
+
+	auto dist = jw_distance(query.text, entry.name, false);
+	if (dist > 0.66)
+		return 1500 - (500 * dist);
+
+	return 0;
+}
@@ -0,0 +1,77 @@
+#pragma once
+#ifndef ES_APP_SEARCH_INDEX_H
+#define ES_APP_SEARCH_INDEX_H
+
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+class FileData;
+
+// Text search data of the games of a FileFilterIndex : case folded names, words and pinyin initials.
+// Postings by trigram and by word give the few games a text filter can match, so a search only scores those
+// instead of every game of the system. They are built on the first search, then kept up to date by add & remove.
+// The entry of a game is built again when its metadata changed since it was created (name imported by a scraper...).
+class SearchIndex
+{
+public:
+	struct Query
+	{
+		std::string text;
+		bool useRelevancy;
+		bool usePinyin;
+
+		std::string folded;
+		std::vector<std::string> tokens; // Case folded alternatives (comma separated in the text) when relevancy is not used
+		std::vector<std::string> words;  // Significant words compared when relevancy is used
+	};
+
+	SearchIndex();
+
+	static Query createQuery(const std::string& text, bool useRelevancy, bool usePinyin);
+
+	void add(FileData* game);
+	void remove(FileData* game);
+	void clear();
+
+	inline bool contains(FileData* game) const { return mEntries.find(game) != mEntries.cend(); }
+
+	// False if the metadata of the game changed since its entry was created
+	bool isUpToDate(FileData* game) const;
+	void update(FileData* game);
+
+	// Scores of the matching games, as returned by FileFilterIndex::showFile
+	void search(const Query& query, std::unordered_map<FileData*, int>& scores);
+
+	// For a game which is not in the index
+	static int getScore(FileData* game, const Query& query);
+
+private:
+	struct Entry
+	{
+		std::string name;
+		std::string folded;
+		std::vector<std::string> words;
+		std::vector<const char*> pinyin;
+		unsigned int version; // of the metadata the entry was created from
+	};
+
+	static void createEntry(FileData* game, Entry& entry);
+	static int getScore(const Entry& entry, const Query& query);
+
+	void addPostings(FileData* game, const Entry& entry);
+	void removePostings(FileData* game, const Entry& entry);
+	void buildPostings();
+
+	// Shortest posting list of the trigrams of 'folded', nullptr if it is too short to have trigrams
+	const std::vector<FileData*>* getCandidates(const std::string& folded);
+
+	std::unordered_map<FileData*, Entry> mEntries;
+	std::unordered_map<unsigned int, std::vector<FileData*>> mTrigrams;
+	std::unordered_map<std::string, std::vector<FileData*>> mWords;
+	std::unordered_set<FileData*> mPinyinGames;
+	bool mHasPostings;
+};
+
+#endif // ES_APP_SEARCH_INDEX_H
@@ -7,6 +7,7 @@
 #include "FileFilterIndex.h"
 #include "FileSorts.h"
 #include "Gamelist.h"
+#include "LibraryCache.h"
 #include "Log.h"
 #include "utils/Platform.h"
 #include "Settings.h"
@@ -21,6 +22,9 @@
 #include "ThreadedHasher.h"
 #include <unordered_set>
 #include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
 #include <functional>
 #include "SaveStateRepository.h"
 #include "Paths.h"
@@ -63,6 +67,16 @@ static std::map<std::string, std::function<BindableProperty(SystemData*)>> prope
 VectorEx<SystemData*> SystemData::sSystemVector;
 bool SystemData::IsManufacturerSupported = false;
 
+// Incremented when a setting changes : SystemSettings snapshots with another version are built again
+static std::atomic<unsigned int> sSettingsVersion(0);
+
+class SystemSettingsListener : public ISettingsChangedEvent
+{
+public:
+	SystemSettingsListener() { Settings::settingChanged += this; }
+	void onSettingChanged(const std::string& /*name*/) override { sSettingsVersion++; }
+};
+
 SystemData::SystemData(const SystemMetadata& meta, SystemEnvironmentData* envData, std::vector<EmulatorData>* pEmulators, bool CollectionSystem, bool groupedSystem, bool withTheme, bool loadThemeOnlyIfElements) :
 	mMetadata(meta), mEnvData(envData), mIsCollectionSystem(CollectionSystem), mIsGameSystem(true)
 {
@@ -76,6 +90,8 @@ SystemData::SystemData(const SystemMetadata& meta, SystemEnvironmentData* envDat
 	mGridSizeOverride = Vector2f(0, 0);
 
 	mFilterIndex = nullptr;
+	mForeignFolders = 0;
+	mLibrarySources = nullptr;
 
 	if (pEmulators != nullptr)
 		mEmulators = *pEmulators;
@@ -94,9 +110,12 @@ SystemData::SystemData(const SystemMetadata& meta, SystemEnvironmentData* envDat
 		std::unordered_map<std::string, FileData*> fileMap;
 		fileMap[mEnvData->mStartPath] = mRootFolder;
 
+		bool fromCache = LibraryCache::isEnabled() && LibraryCache::load(this, fileMap);
+
 		if (!Settings::ParseGamelistOnly())
 		{
-			populateFolder(mRootFolder, fileMap);
+			if (!fromCache)
+				populateFolder(mRootFolder, fileMap);
 
 			if (!UIModeController::LoadEmptySystems())
 			{
@@ -108,11 +127,15 @@ SystemData::SystemData(const SystemMetadata& meta, SystemEnvironmentData* envDat
 			}
 		}
 
-		if (!Settings::IgnoreGamelist())
-			parseGamelist(this, fileMap);		
-		
-		if (Settings::RemoveMultiDiskContent())
-			removeMultiDiskContent(fileMap);
+		// The snapshot was taken after the gamelist was parsed & the multi-disk content removed
+		if (!fromCache)
+		{
+			if (!Settings::IgnoreGamelist())
+				parseGamelist(this, fileMap);
+
+			if (Settings::RemoveMultiDiskContent())
+				removeMultiDiskContent(fileMap);
+		}
 	}
 	else
 	{
@@ -146,6 +169,9 @@ SystemData::~SystemData()
 	if (mRootFolder)
 		delete mRootFolder;
 
+	if (mLibrarySources != nullptr)
+		delete mLibrarySources;
+
 	if (!mIsCollectionSystem && mEnvData != nullptr)
 		delete mEnvData;
 
@@ -226,12 +252,76 @@ void SystemData::setIsGameSystemStatus()
 	mIsGameSystem = (mMetadata.name != "retropie" && mMetadata.name != "retrobat");
 }
 
+// Listing of one directory, in directory order. Sub folders are listed by their own FolderScan, possibly on another thread.
+struct SystemData::FolderScan
+{
+	struct Entry
+	{
+		FileData* game;
+		std::unique_ptr<FolderScan> folder;
+	};
+
+	FolderScan(FolderData* data) : folder(data) { }
+
+	FolderData* folder;
+	std::vector<Entry> entries;
+
+	// Date of the folder before it was listed, for the library cache
+	LibrarySources::Stamp stamp;
+};
+
+struct SystemData::FolderScanOptions
+{
+	bool showHidden;
+	bool preloadMedias;
+	bool stampFolders;
+};
+
+// The folder scans of every system being populated share one pool of hardware_concurrency() threads : systems loaded
+// in parallel by loadConfig don't start a pool each, and a big tree still gets every core once the small ones are done.
+// The pool only lives while a system is being populated.
+static std::mutex sFolderScanPoolLock;
+static ThreadPool* sFolderScanPool = nullptr;
+static int sFolderScanPoolUsers = 0;
+
+static ThreadPool* acquireFolderScanPool()
+{
+	std::lock_guard<std::mutex> lock(sFolderScanPoolLock);
+
+	if (sFolderScanPool == nullptr)
+	{
+		sFolderScanPool = new ThreadPool(-(int)std::thread::hardware_concurrency());
+		sFolderScanPool->start();
+	}
+
+	sFolderScanPoolUsers++;
+	return sFolderScanPool;
+}
+
+static void releaseFolderScanPool()
+{
+	std::lock_guard<std::mutex> lock(sFolderScanPoolLock);
+
+	if (--sFolderScanPoolUsers == 0)
+	{
+		delete sFolderScanPool;
+		sFolderScanPool = nullptr;
+	}
+}
+
 void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap)
 {
-	const std::string& folderPath = folder->getPath();
+	if (!Utils::FileSystem::isDirectory(folder->getPath()))
+	{
+		// The folder appearing invalidates the library cache
+		if (mLibrarySources != nullptr)
+		{
+			mLibrarySources->folders.push_back(LibrarySources::Stamp());
+			LibraryCache::stampFolder(mLibrarySources->folders.back(), folder->getPath());
+		}
 
-	if(!Utils::FileSystem::isDirectory(folderPath))
 		return;
+	}
 	/*
 	// [Obsolete] make sure that this isn't a symlink to a thing we already have
 	// Deactivated because it's slow & useless : users should to be carefull not to make recursive simlinks
@@ -245,23 +335,92 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 		}
 	}
 	*/
+	FolderScanOptions options;
+	options.showHidden = getSettings()->showHiddenFiles;
+	options.preloadMedias = Settings::PreloadMedias();
+	options.stampFolders = mLibrarySources != nullptr;
+
+	// The root folder is listed by the calling thread : flat systems never start a thread
+	FolderScan root(folder);
+	std::vector<FolderScan*> subFolders;
+	scanFolder(&root, options, [&subFolders](FolderScan* scan) { subFolders.push_back(scan); });
+
+	if (subFolders.size() > 0 && std::thread::hardware_concurrency() > 1 && Settings::ThreadedLoading())
+	{
+		// Every folder found is queued to the shared pool : idle threads take the next pending folder whatever its depth,
+		// so one big tree is spread over all the cores. Each scan only fills its own FolderScan.
+		ThreadPool* pool = acquireFolderScanPool();
+
+		// Other systems use the pool too : this one waits for its own folders only
+		std::atomic<int> pending(0);
+		std::mutex doneLock;
+		std::condition_variable done;
+
+		std::function<void(FolderScan*)> queueFolder;
+		queueFolder = [this, pool, &options, &queueFolder, &pending, &doneLock, &done](FolderScan* scan)
+		{
+			pending++;
+
+			pool->queueWorkItem([this, scan, &options, &queueFolder, &pending, &doneLock, &done]
+			{
+				try
+				{
+					scanFolder(scan, options, queueFolder);
+				}
+				catch (...) {}
+
+				// Sub folders were queued before : the count only reaches 0 when the whole tree is scanned
+				if (--pending == 0)
+				{
+					std::lock_guard<std::mutex> lock(doneLock);
+					done.notify_all();
+				}
+			});
+		};
+
+		for (auto scan : subFolders)
+			queueFolder(scan);
+
+		{
+			std::unique_lock<std::mutex> lock(doneLock);
+			done.wait(lock, [&pending] { return pending.load() == 0; });
+		}
+
+		releaseFolderScanPool();
+	}
+	else
+	{
+		std::function<void(FolderScan*)> scanNow;
+		scanNow = [this, &options, &scanNow](FolderScan* scan) { scanFolder(scan, options, scanNow); };
+
+		for (auto scan : subFolders)
+			scanNow(scan);
+	}
+
+	// Build the tree on this thread, in the same order as a recursive walk would
+	mergeFolderScan(&root, fileMap);
+}
+
+void SystemData::scanFolder(FolderScan* scan, const FolderScanOptions& options, const std::function<void(FolderScan*)>& queueFolder)
+{
+	const std::string& folderPath = scan->folder->getPath();
+
+	if (options.stampFolders)
+		LibraryCache::stampFolder(scan->stamp, folderPath);
+
 	std::string filePath;
 	std::string extension;
 	bool isGame;
-	bool showHidden = Settings::ShowHiddenFiles();
-	bool preloadMedias = Settings::PreloadMedias();
-
-	auto shv = Settings::getInstance()->getString(getName() + ".ShowHiddenFiles");
-	if (shv == "1") showHidden = true;
-	else if (shv == "0") showHidden = false;
 
 	Utils::FileSystem::fileList dirContent = Utils::FileSystem::getDirectoryFiles(folderPath);
+	scan->entries.reserve(dirContent.size());
+
 	for (auto fileInfo : dirContent)
 	{
 		filePath = fileInfo.path;
 
 		// skip hidden files and folders
-		if(!showHidden && fileInfo.hidden)
+		if(!options.showHidden && fileInfo.hidden)
 			continue;
 
 		//this is a little complicated because we allow a list of extensions to be defined (delimited with a space)
@@ -277,12 +436,15 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 			FileData* newGame = new FileData(GAME, filePath, this);
 
 			// preventing new arcade assets to be added
-			if(!newGame->isArcadeAsset())
+			if (!newGame->isArcadeAsset())
 			{
-				folder->addChild(newGame);
-				fileMap[filePath] = newGame;
+				FolderScan::Entry entry;
+				entry.game = newGame;
+				scan->entries.push_back(std::move(entry));
 				isGame = true;
 			}
+			else
+				delete newGame;
 		}
 
 		//add directories that also do not match an extension as folders
@@ -294,7 +456,7 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 			if (fn == "artwork")
 				continue;
 
-			if (preloadMedias && (!mHidden || Settings::HiddenSystemsShowGames()))
+			if (options.preloadMedias && (!mHidden || Settings::HiddenSystemsShowGames()))
 			{
 				// Recurse list files in medias folder, just to let OS build filesystem cache 
 				if (fn == "media" || fn == "medias")
@@ -323,20 +485,47 @@ void SystemData::populateFolder(FolderData* folder, std::unordered_map<std::stri
 			if (mMetadata.name == "vpinball" && fn == "roms")
 				continue;			
 
-			FolderData* newFolder = new FolderData(filePath, this);
-			populateFolder(newFolder, fileMap);
+			FolderScan::Entry entry;
+			entry.game = nullptr;
+			entry.folder = std::unique_ptr<FolderScan>(new FolderScan(new FolderData(filePath, this)));
+
+			// The entry owns the scan : the pointer stays valid when 'entries' grows
+			FolderScan* subFolder = entry.folder.get();
+			scan->entries.push_back(std::move(entry));
+			queueFolder(subFolder);
+		}
+	}
+}
+
+void SystemData::mergeFolderScan(FolderScan* scan, std::unordered_map<std::string, FileData*>& fileMap)
+{
+	FolderData* folder = scan->folder;
+
+	if (mLibrarySources != nullptr)
+		mLibrarySources->folders.push_back(scan->stamp);
+
+	for (auto& entry : scan->entries)
+	{
+		if (entry.game != nullptr)
+		{
+			folder->addChild(entry.game);
+			fileMap[entry.game->getPath()] = entry.game;
+			continue;
+		}
+
+		FolderData* newFolder = entry.folder->folder;
+		mergeFolderScan(entry.folder.get(), fileMap);
 
-			//ignore folders that do not contain games
-			if(newFolder->getChildren().size() == 0)
-				delete newFolder;
-			else 
+		//ignore folders that do not contain games
+		if(newFolder->getChildren().size() == 0)
+			delete newFolder;
+		else 
+		{
+			const std::string& key = newFolder->getPath();
+			if (fileMap.find(key) == fileMap.end())
 			{
-				const std::string& key = newFolder->getPath();
-				if (fileMap.find(key) == fileMap.end())
-				{
-					folder->addChild(newFolder);
-					fileMap[key] = newFolder;
-				}
+				folder->addChild(newFolder);
+				fileMap[key] = newFolder;
 			}
 		}
 	}
@@ -363,6 +552,51 @@ void SystemData::deleteIndex()
 	}
 }
 
+void SystemData::addToPathIndex(FileData* file)
+{
+	if (file->getType() == FOLDER && (file->getSystem() != this || ((FolderData*)file)->isVirtualStorage()))
+		mForeignFolders++;
+
+	mPathIndex.emplace(file->getPath(), file);
+}
+
+void SystemData::removeFromPathIndex(FileData* file)
+{
+	if (mPathIndex.empty())
+		return;
+
+	auto range = mPathIndex.equal_range(file->getPath());
+	for (auto it = range.first; it != range.second; ++it)
+	{
+		if (it->second != file)
+			continue;
+
+		if (file->getType() == FOLDER && (file->getSystem() != this || ((FolderData*)file)->isVirtualStorage()))
+			mForeignFolders--;
+
+		mPathIndex.erase(it);
+		break;
+	}
+}
+
+void SystemData::clearPathIndex()
+{
+	mPathIndex.clear();
+	mForeignFolders = 0;
+}
+
+FileData* SystemData::findInPathIndex(const std::string& path, FolderData* folder)
+{
+	// Several systems can share a rom folder : the same path can be found more than once in collections
+	auto range = mPathIndex.equal_range(path);
+	for (auto it = range.first; it != range.second; ++it)
+		for (auto parent = it->second->getParent(); parent != nullptr; parent = parent->getParent())
+			if (parent == folder)
+				return it->second;
+
+	return nullptr;
+}
+
 void SystemData::indexAllGameFilters(const FolderData* folder)
 {
 	const std::vector<FileData*>& children = folder->getChildren();
@@ -1216,8 +1450,13 @@ void SystemData::deleteSystems()
 		SystemData* pData = sSystemVector.at(i);
 		pData->getRootFolder()->removeVirtualFolders();
 
+		bool saveLibrary = LibraryCache::canSave(pData);
+
 		if (saveOnExit && !pData->mIsCollectionSystem)
-			updateGamelist(pData);
+			saveLibrary = updateGamelist(pData) && saveLibrary;
+
+		if (saveLibrary)
+			LibraryCache::save(pData);
 
 		delete pData;
 	}
@@ -1974,6 +2213,8 @@ void SystemData::resetSettings()
 {
 	for(auto sys : sSystemVector)
 		sys->mShowFilenames.reset();
+
+	sSettingsVersion++;
 }
 
 SaveStateRepository* SystemData::getSaveStateRepository()
@@ -2016,7 +2257,7 @@ bool SystemData::getBoolSetting(const std::string& settingName)
 
 bool SystemData::getShowParentFolder()
 {
-	return getBoolSetting("ShowParentFolder");
+	return getSettings()->showParentFolder;
 }
 
 std::string SystemData::getFolderViewMode()
@@ -2024,26 +2265,61 @@ std::string SystemData::getFolderViewMode()
 	if (this == CollectionSystemManager::get()->getCustomCollectionsBundle())
 		return "always";
 
-	std::string showFoldersMode = Settings::getInstance()->getString("FolderViewMode");
+	return getSettings()->folderViewMode;
+}
 
-	auto fvm = Settings::getInstance()->getString(getName() + ".FolderViewMode");
-	if (!fvm.empty() && fvm != "auto") 
-		showFoldersMode = fvm;
+bool SystemData::getShowFavoritesFirst()
+{
+	return getSettings()->showFavoritesFirst;
+}
 
-	if ((fvm.empty() || fvm == "auto") && this == CollectionSystemManager::get()->getCustomCollectionsBundle())
-		showFoldersMode = "always";
-	else if (getName() == "windows_installers")
-		showFoldersMode = "always";
+std::shared_ptr<const SystemSettings> SystemData::getSettings()
+{
+	static SystemSettingsListener listener;
+
+	auto settings = std::atomic_load(&mSettings);
+	if (settings != nullptr && settings->version == sSettingsVersion)
+		return settings;
 
-	return showFoldersMode;
+	settings = createSettings();
+	std::atomic_store(&mSettings, settings);
+	return settings;
 }
 
-bool SystemData::getShowFavoritesFirst()
+std::shared_ptr<const SystemSettings> SystemData::createSettings()
 {
-	if (!getShowFavoritesIcon())
-		return false;
+	auto settings = std::make_shared<SystemSettings>();
+	settings->version = sSettingsVersion;
+
+	settings->showHiddenFiles = Settings::ShowHiddenFiles();
+	settings->showHiddenFilesOverriden = false;
+
+	auto shv = Settings::getInstance()->getString(getName() + ".ShowHiddenFiles");
+	if (shv == "1" || shv == "0")
+	{
+		settings->showHiddenFiles = (shv == "1");
+		settings->showHiddenFilesOverriden = true;
+	}
+
+	if (isGameSystem() && !isCollection())
+		for (auto ext : Utils::String::split(Utils::String::toLower(Settings::getInstance()->getString(getName() + ".HiddenExt")), ';'))
+			settings->hiddenExtensions.insert(ext);
+
+	settings->folderViewMode = Settings::getInstance()->getString("FolderViewMode");
+
+	auto fvm = Settings::getInstance()->getString(getName() + ".FolderViewMode");
+	if (!fvm.empty() && fvm != "auto") 
+		settings->folderViewMode = fvm;
+
+	if (getName() == "windows_installers")
+		settings->folderViewMode = "always";
+
+	settings->showParentFolder = getBoolSetting("ShowParentFolder");
+	settings->showFavoritesFirst = getShowFavoritesIcon() && getBoolSetting("FavoritesFirst");
+	settings->localArt = Settings::getInstance()->getBool("LocalArt");
+	settings->forceDisableFilters = Settings::getInstance()->getBool("ForceDisableFilters");
 
-	return getBoolSetting("FavoritesFirst");
+	return settings;
 }
 
 bool SystemData::getShowFavoritesIcon()
@@ -12,6 +12,7 @@
 #include <pugixml/src/pugixml.hpp>
 #include <unordered_map>
 #include <unordered_set>
+#include <functional>
 #include "FileFilterIndex.h"
 #include "KeyboardMapping.h"
 #include "math/Vector2f.h"
@@ -24,6 +25,7 @@ class FolderData;
 class ThemeData;
 class Window;
 class SaveStateRepository;
+struct LibrarySources;
 
 struct GameCountInfo
 {
@@ -62,6 +64,22 @@ struct SystemEnvironmentData
 	}
 };
 
+// Settings of a system read while listing & displaying its games. A snapshot is never modified : a new one is built
+// the first time it is needed after a setting changed, and callers keep the pointer they got while they use it.
+struct SystemSettings
+{
+	unsigned int version;
+
+	bool showHiddenFiles;						// <system>.ShowHiddenFiles, else ShowHiddenFiles
+	bool showHiddenFilesOverriden;				// <system>.ShowHiddenFiles is set, kiosk mode does not hide them
+	std::set<std::string> hiddenExtensions;		// lower case <system>.HiddenExt, only for game systems which are not collections
+	std::string folderViewMode;
+	bool showParentFolder;
+	bool showFavoritesFirst;
+	bool localArt;
+	bool forceDisableFilters;
+};
+
 class SystemData;
 
 class BindableRandom : public IBindable
@@ -164,6 +182,15 @@ public:
 		if (mFilterIndex != nullptr) mFilterIndex->setUIModeFilters();
 	}
 
+	// Files attached to the folders of this system, by path. Maintained by FolderData::addChild/removeChild, used by FolderData::FindByPath
+	void addToPathIndex(FileData* file);
+	void removeFromPathIndex(FileData* file);
+	void clearPathIndex();
+	FileData* findInPathIndex(const std::string& path, FolderData* folder);
+
+	// False when the system holds folders of other systems or virtual storages : their files are not in the path index
+	bool isPathIndexComplete() { return mForeignFolders == 0; }
+
 	std::vector<EmulatorData> getEmulators() { return mEmulators; }
 
 	unsigned int getSortId() const { return mSortId; };
@@ -223,6 +250,8 @@ public:
 	std::string getFolderViewMode();
 	bool getBoolSetting(const std::string& settingName);
 
+	std::shared_ptr<const SystemSettings> getSettings();
+
 	static void resetSettings();
 
 	SaveStateRepository* getSaveStateRepository();
@@ -248,7 +277,12 @@ private:
 	SystemEnvironmentData* mEnvData;
 	std::shared_ptr<ThemeData> mTheme;
 
+	struct FolderScan;
+	struct FolderScanOptions;
+
 	void populateFolder(FolderData* folder, std::unordered_map<std::string, FileData*>& fileMap);
+	void scanFolder(FolderScan* scan, const FolderScanOptions& options, const std::function<void(FolderScan*)>& queueFolder);
+	void mergeFolderScan(FolderScan* scan, std::unordered_map<std::string, FileData*>& fileMap);
 	void indexAllGameFilters(const FolderData* folder);
 	void setIsGameSystemStatus();
 	void removeMultiDiskContent(std::unordered_map<std::string, FileData*>& fileMap);
@@ -258,6 +292,9 @@ private:
 
 	FileFilterIndex* mFilterIndex;
 
+	std::unordered_multimap<std::string, FileData*> mPathIndex;
+	int mForeignFolders;
+
 	FolderData* mRootFolder;
 	BindableRandom* mBindableRandom;
 
@@ -269,10 +306,16 @@ private:
 	
 	std::shared_ptr<bool> mShowFilenames;
 
+	std::shared_ptr<const SystemSettings> createSettings();
+	std::shared_ptr<const SystemSettings> mSettings;
+
 	GameCountInfo* mGameCountInfo;
 	SaveStateRepository* mSaveRepository;
 
 	bool mHidden;
+
+	friend class LibraryCache;
+	LibrarySources* mLibrarySources;
 };
 
 #endif // ES_APP_SYSTEM_DATA_H
@@ -0,0 +1,322 @@
+#include "components/VisemeAtlasComponent.h"
+
+#include "resources/ResourceManager.h"
+#include "resources/TextureResource.h"
+#include "ImageIO.h"
+#include "Log.h"
+#include <algorithm>
+#include <cstring>
+
+// Copies a w*h rect at (dx, dy), surrounded by a 1 pixel border duplicating its edges so linear filtering never samples a neighbour tile
+static void blitExtruded(unsigned int* dst, int dstWidth, int dx, int dy, const unsigned int* src, int srcWidth, int sx, int sy, int w, int h)
+{
+	for (int y = -1; y <= h; y++)
+	{
+		const unsigned int* srcRow = src + (sy + std::min(std::max(y, 0), h - 1)) * srcWidth;
+		unsigned int* dstRow = dst + (dy + y) * dstWidth;
+
+		for (int x = -1; x <= w; x++)
+			dstRow[dx + x] = srcRow[sx + std::min(std::max(x, 0), w - 1)];
+	}
+}
+
+VisemeAtlasComponent::VisemeAtlasComponent(Window* window) : GuiComponent(window),
+	mHasBase(false), mFace(0), mPreviousFace(-1), mBlend(1.0f)
+{
+	mCrossfadeShader.path = ":/shaders/viseme_crossfade.glsl";
+}
+
+bool VisemeAtlasComponent::setFaces(const std::vector<std::string>& paths)
+{
+	mPaths = paths;
+	mFace = 0;
+	mPreviousFace = -1;
+
+	bool ret = buildAtlas();
+	updateVertices();
+	return ret;
+}
+
+bool VisemeAtlasComponent::buildAtlas()
+{
+	mTiles.clear();
+	mTexture = nullptr;
+	mHasBase = false;
+
+	if (mPaths.empty())
+		return false;
+
+	std::vector<unsigned char*> faces;
+	size_t width = 0;
+	size_t height = 0;
+
+	for (auto& path : mPaths)
+	{
+		const ResourceData data = ResourceManager::getInstance()->getFileData(path);
+
+		size_t w = 0;
+		size_t h = 0;
+		unsigned char* pixels = data.ptr != nullptr ? ImageIO::loadFromMemoryRGBA32(data.ptr.get(), data.length, w, h) : nullptr;
+		if (pixels == nullptr || (!faces.empty() && (w != width || h != height)))
+		{
+			LOG(LogError) << "VisemeAtlasComponent : Unable to load face " << path;
+
+			if (pixels != nullptr)
+				delete[] pixels;
+
+			for (auto face : faces)
+				delete[] face;
+
+			return false;
+		}
+
+		width = w;
+		height = h;
+		faces.push_back(pixels);
+	}
+
+	// Pixels are stored bottom-up : all the atlas computations are made in buffer rows
+	int W = (int)width;
+	int H = (int)height;
+
+	const unsigned int* base = (const unsigned int*)faces[0];
+
+	// Find the area where the faces differ from the first one
+	int x0 = W, y0 = H, x1 = -1, y1 = -1;
+	for (size_t i = 1; i < faces.size(); i++)
+	{
+		const unsigned int* face = (const unsigned int*)faces[i];
+
+		for (int y = 0; y < H; y++)
+		{
+			if (memcmp(face + y * W, base + y * W, W * 4) == 0)
+				continue;
+
+			for (int x = 0; x < W; x++)
+			{
+				if (face[y * W + x] == base[y * W + x])
+					continue;
+
+				x0 = std::min(x0, x);
+				x1 = std::max(x1, x);
+				y0 = std::min(y0, y);
+				y1 = std::max(y1, y);
+			}
+		}
+	}
+
+	if (x1 < 0)
+		x0 = y0 = x1 = y1 = 0;
+
+	int rx = x0;
+	int ry = y0;
+	int rw = x1 - x0 + 1;
+	int rh = y1 - y0 + 1;
+
+	// Tiles are drawn over the base face, which is only right if they are opaque
+	bool opaque = true;
+	for (size_t i = 0; i < faces.size() && opaque; i++)
+	{
+		for (int y = ry; y < ry + rh && opaque; y++)
+			for (int x = rx; x < rx + rw; x++)
+				if (faces[i][(y * W + x) * 4 + 3] != 0xFF) { opaque = false; break; }
+	}
+
+	if (!opaque)
+	{
+		rx = ry = 0;
+		rw = W;
+		rh = H;
+	}
+
+	mHasBase = (rw < W || rh < H);
+
+	// Layout : base face first, then the tiles in rows. Each rect has a 1 pixel extruded border.
+	int cellW = rw + 2;
+	int cellH = rh + 2;
+	int baseH = mHasBase ? H + 2 : 0;
+
+	int atlasWidth = std::max(mHasBase ? W + 2 : 0, cellW);
+	int perRow = std::max(1, atlasWidth / cellW);
+	int rows = ((int)faces.size() + perRow - 1) / perRow;
+	int atlasHeight = baseH + rows * cellH;
+
+	auto makeTile = [atlasWidth, atlasHeight](int x, int y, int w, int h)
+	{
+		Tile tile;
+		tile.uvTopLeft = Vector2f((float)x / atlasWidth, (float)(y + h) / atlasHeight);
+		tile.uvBottomRight = Vector2f((float)(x + w) / atlasWidth, (float)y / atlasHeight);
+		return tile;
+	};
+
+	std::vector<unsigned int> atlas((size_t)atlasWidth * atlasHeight, 0);
+
+	if (mHasBase)
+	{
+		blitExtruded(atlas.data(), atlasWidth, 1, 1, base, W, 0, 0, W, H);
+		mBase = makeTile(1, 1, W, H);
+	}
+
+	for (int i = 0; i < (int)faces.size(); i++)
+	{
+		int cx = (i % perRow) * cellW + 1;
+		int cy = baseH + (i / perRow) * cellH + 1;
+
+		blitExtruded(atlas.data(), atlasWidth, cx, cy, (const unsigned int*)faces[i], W, rx, ry, rw, rh);
+		mTiles.push_back(makeTile(cx, cy, rw, rh));
+	}
+
+	for (auto face : faces)
+		delete[] face;
+
+	mFaceSize = Vector2f(W, H);
+	mRegionPos = Vector2f(rx, H - (ry + rh));
+	mRegionSize = Vector2f(rw, rh);
+
+	mTexture = TextureResource::get("", false, true);
+	mTexture->initFromPixels((unsigned char*)atlas.data(), atlasWidth, atlasHeight);
+
+	LOG(LogDebug) << "VisemeAtlasComponent : " << faces.size() << " faces packed in " << atlasWidth << "x" << atlasHeight;
+	return true;
+}
+
+void VisemeAtlasComponent::setFace(int index)
+{
+	if (index >= 0 && index < (int)mTiles.size())
+		mFace = index;
+
+	mPreviousFace = -1;
+}
+
+void VisemeAtlasComponent::setCrossfade(int previous, float blend)
+{
+	if (previous < 0 || previous >= (int)mTiles.size() || previous == mFace || blend >= 1.0f)
+	{
+		mPreviousFace = -1;
+		return;
+	}
+
+	blend = std::max(0.0f, blend);
+	if (blend != mBlend)
+	{
+		mBlend = blend;
+		mCrossfadeShader.parameters["blend"] = std::to_string(mBlend);
+	}
+
+	if (previous == mPreviousFace)
+		return;
+
+	mPreviousFace = previous;
+
+	// All tiles have the same size : the previous tile is sampled at a constant offset from the current one
+	const Tile& from = mTiles[mFace];
+	const Tile& to = mTiles[mPreviousFace];
+	mCrossfadeShader.parameters["previousOffset"] = std::to_string(to.uvTopLeft.x() - from.uvTopLeft.x()) + " " + std::to_string(to.uvTopLeft.y() - from.uvTopLeft.y());
+}
+
+void VisemeAtlasComponent::setResize(float width)
+{
+	if (mFaceSize.x() <= 0)
+		setSize(width, 0);
+	else
+		setSize(width, width * mFaceSize.y() / mFaceSize.x());
+}
+
+void VisemeAtlasComponent::onSizeChanged()
+{
+	GuiComponent::onSizeChanged();
+	updateVertices();
+}
+
+void VisemeAtlasComponent::updateVertices()
+{
+	if (mFaceSize.x() <= 0 || mFaceSize.y() <= 0)
+		return;
+
+	Vector2f scale(mSize.x() / mFaceSize.x(), mSize.y() / mFaceSize.y());
+
+	Vector2f topLeft(mRegionPos.x() * scale.x(), mRegionPos.y() * scale.y());
+	Vector2f bottomRight((mRegionPos.x() + mRegionSize.x()) * scale.x(), (mRegionPos.y() + mRegionSize.y()) * scale.y());
+
+	mBaseVertices[0] = { { 0.0f,       0.0f       }, { mBase.uvTopLeft.x(),     mBase.uvTopLeft.y()     }, 0xFFFFFFFF };
+	mBaseVertices[1] = { { 0.0f,       mSize.y()  }, { mBase.uvTopLeft.x(),     mBase.uvBottomRight.y() }, 0xFFFFFFFF };
+	mBaseVertices[2] = { { mSize.x(),  0.0f       }, { mBase.uvBottomRight.x(), mBase.uvTopLeft.y()     }, 0xFFFFFFFF };
+	mBaseVertices[3] = { { mSize.x(),  mSize.y()  }, { mBase.uvBottomRight.x(), mBase.uvBottomRight.y() }, 0xFFFFFFFF };
+
+	mTileVertices[0] = { { topLeft.x(),     topLeft.y()     }, { 0.0f, 0.0f }, 0xFFFFFFFF };
+	mTileVertices[1] = { { topLeft.x(),     bottomRight.y() }, { 0.0f, 0.0f }, 0xFFFFFFFF };
+	mTileVertices[2] = { { bottomRight.x(), topLeft.y()     }, { 0.0f, 0.0f }, 0xFFFFFFFF };
+	mTileVertices[3] = { { bottomRight.x(), bottomRight.y() }, { 0.0f, 0.0f }, 0xFFFFFFFF };
+}
+
+void VisemeAtlasComponent::setTileTexCoords(const Tile& tile)
+{
+	mTileVertices[0].tex = Vector2f(tile.uvTopLeft.x(), tile.uvTopLeft.y());
+	mTileVertices[1].tex = Vector2f(tile.uvTopLeft.x(), tile.uvBottomRight.y());
+	mTileVertices[2].tex = Vector2f(tile.uvBottomRight.x(), tile.uvTopLeft.y());
+	mTileVertices[3].tex = Vector2f(tile.uvBottomRight.x(), tile.uvBottomRight.y());
+}
+
+void VisemeAtlasComponent::render(const Transform4x4f& parentTrans)
+{
+	if (!isVisible() || mPaths.empty())
+		return;
+
+	// The atlas is built from memory and can't be reloaded from a path : rebuild it if the renderer was reinitialized
+	if (mTexture == nullptr || !mTexture->isLoaded())
+	{
+		if (mTiles.empty() || !buildAtlas())
+			return;
+
+		updateVertices();
+	}
+
+	Transform4x4f trans = parentTrans * getTransform();
+
+	if (getOpacity() > 0 && mTexture->bind())
+	{
+		Renderer::setMatrix(trans);
+
+		const unsigned int color = Renderer::convertColor(0xFFFFFF00 | getOpacity());
+
+		if (mHasBase)
+		{
+			for (int i = 0; i < 4; i++)
+				mBaseVertices[i].col = color;
+
+			Renderer::drawTriangleStrips(&mBaseVertices[0], 4);
+		}
+
+		for (int i = 0; i < 4; i++)
+			mTileVertices[i].col = color;
+
+		if (mPreviousFace < 0)
+		{
+			setTileTexCoords(mTiles[mFace]);
+			Renderer::drawTriangleStrips(&mTileVertices[0], 4);
+		}
+		else if (Renderer::supportShaders())
+		{
+			// Both tiles are sampled and mixed by the shader : still a single draw
+			setTileTexCoords(mTiles[mFace]);
+			mTileVertices[0].customShader = &mCrossfadeShader;
+			Renderer::drawTriangleStrips(&mTileVertices[0], 4);
+			mTileVertices[0].customShader = nullptr;
+		}
+		else
+		{
+			// Previous tile, then the current one on top with the blend as alpha
+			setTileTexCoords(mTiles[mPreviousFace]);
+			Renderer::drawTriangleStrips(&mTileVertices[0], 4);
+
+			const unsigned int blendColor = Renderer::convertColor(0xFFFFFF00 | (unsigned char)(getOpacity() * mBlend));
+			for (int i = 0; i < 4; i++)
+				mTileVertices[i].col = blendColor;
+
+			setTileTexCoords(mTiles[mFace]);
+			Renderer::drawTriangleStrips(&mTileVertices[0], 4);
+		}
+	}
+
+	GuiComponent::renderChildren(trans);
+}
@@ -0,0 +1,74 @@
+#pragma once
+#ifndef ES_APP_COMPONENTS_VISEME_ATLAS_COMPONENT_H
+#define ES_APP_COMPONENTS_VISEME_ATLAS_COMPONENT_H
+
+#include "GuiComponent.h"
+#include "renderers/Renderer.h"
+#include <memory>
+#include <string>
+#include <vector>
+
+class TextureResource;
+
+// Displays one of a set of same-sized face images, all packed once in a single texture.
+// The atlas holds the first face in full, plus one tile per face covering only the area where the faces
+// differ (the mouth). Switching faces only selects another tile : no texture lookup, no allocation.
+// Transitions blend two tiles in a single draw with the viseme_crossfade shader (two blended draws without shader support).
+// The texture is not managed by the TextureDataManager so it can't be evicted by cleanupVRAM.
+class VisemeAtlasComponent : public GuiComponent
+{
+public:
+	VisemeAtlasComponent(Window* window);
+
+	// Loads and packs the faces. All images must have the same size.
+	bool setFaces(const std::vector<std::string>& paths);
+
+	// Selecting a face cancels the crossfade
+	void setFace(int index);
+	int getFace() const { return mFace; }
+
+	// Blends from 'previous' to the current face. 'blend' is the weight of the current face, 1 (or previous = -1) disables the crossfade.
+	void setCrossfade(int previous, float blend);
+	int getFaceCount() const { return (int)mTiles.size(); }
+
+	// Resize to the given width, keeping the face aspect ratio
+	void setResize(float width);
+
+	void render(const Transform4x4f& parentTrans) override;
+	void onSizeChanged() override;
+
+private:
+	struct Tile
+	{
+		Vector2f uvTopLeft;
+		Vector2f uvBottomRight;
+	};
+
+	bool buildAtlas();
+	void updateVertices();
+	void setTileTexCoords(const Tile& tile);
+
+	std::vector<std::string> mPaths;
+	std::shared_ptr<TextureResource> mTexture;
+
+	Vector2f mFaceSize;
+
+	// Area covered by the tiles, in face pixels (top-left origin)
+	Vector2f mRegionPos;
+	Vector2f mRegionSize;
+
+	bool mHasBase;
+	Tile mBase;
+	std::vector<Tile> mTiles;
+
+	int mFace;
+	int mPreviousFace;
+	float mBlend;
+
+	Renderer::ShaderInfo mCrossfadeShader;
+
+	Renderer::Vertex mBaseVertices[4];
+	Renderer::Vertex mTileVertices[4];
+};
+
+#endif // ES_APP_COMPONENTS_VISEME_ATLAS_COMPONENT_H
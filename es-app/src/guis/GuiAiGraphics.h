@@ -3,18 +3,19 @@
 #define ES_APP_GUIS_GUI_AI_GRAPHICS_H
 
 #include "GuiComponent.h"
-#include "components/ImageComponent.h"
-#include "components/TextComponent.h"
+#include "Settings.h"
+#include "components/StreamingTextComponent.h"
+#include "components/VisemeAtlasComponent.h"
+#include "services/VisemeScheduler.h"
 #include <memory>
 #include <cstdint>
 #include <string>
 #include <vector>
-#include <thread>
-#include <mutex>
-#include <condition_variable>
-#include <atomic>
 
-class GuiAiGraphics : public GuiComponent
+class TextCache;
+class VisemeMap;
+
+class GuiAiGraphics : public GuiComponent, public ISettingsChangedEvent
 {
 public:
     struct VisemeStep {
@@ -22,7 +23,8 @@ public:
         int durationMs; // how long to display this face
     };
 
-    GuiAiGraphics(Window* window);
+    // 'session' selects the phoneme queue of the character shown (LlmStreamService), "" for the default one
+    GuiAiGraphics(Window* window, const std::string& session = "");
     ~GuiAiGraphics() override;
     
     bool input(InputConfig* config, Input input) override;
@@ -30,27 +32,50 @@ public:
     void render(const Transform4x4f& parentTrans) override;
     void onShow() override;
     void onHide() override;
+    void topWindow(bool isTop) override;
     void update(int deltaTime) override;
 
+    void onSettingChanged(const std::string& name) override;
+
 private:
-    std::shared_ptr<ImageComponent> mBackgroundImage;
-    std::shared_ptr<TextComponent>  mTranscript;
+    void loadVisemeMap();
+    std::string getControlCommand(const std::string& command) const;
+
+    // Idle animation (blinks, breathing) on a low rate timer while no phoneme plays
+    void updateIdle(std::uint64_t now);
+    void leaveIdle();
+
+    std::string mSession;
+
+    std::shared_ptr<VisemeAtlasComponent> mFace;
+    std::shared_ptr<StreamingTextComponent> mTranscript;
 
     std::uint64_t mSubId = 0;
-    std::string mDisplayedTranscript;
-    std::string mLastFaceImage{":/BMO_Face/M.png"}; // Start with M (closed mouth)
-    
-    // Phoneme animation queue
-    struct PhonemeQueueItem {
-        std::int64_t phoneme_id;
-        float duration_seconds;
-        std::string faceImage;
-    };
-    std::vector<PhonemeQueueItem> mPhonemeQueue;
-    std::mutex mPhonemeQueueMutex;
-    std::condition_variable mPhonemeQueueCond;
-    std::thread mAnimationThread;
-    std::atomic<bool> mAnimationRunning{false};
+    std::uint64_t mTranscriptSubId = 0;
+
+    // Phoneme -> viseme map of the current voice, and the viseme of the last phoneme placed on the timeline
+    std::shared_ptr<const VisemeMap> mVisemeMap;
+    std::uint32_t mVoiceSerial = 0;
+    int mLastViseme = -1;
+
+    // Phoneme timeline, polled from update()
+    VisemeScheduler mScheduler;
+    bool mPowerSaverPaused = false;
+
+    bool mIdle = false;
+    bool mBlinking = false;
+    std::uint64_t mIdleStartUs = 0;
+    std::uint64_t mNextBlinkUs = 0;
+
+    // Latency of the last face change, recorded when it is first rendered
+    bool mFaceRenderPending = false;
+    std::uint64_t mFaceStartUs = 0;
+    std::uint64_t mFaceProducerUs = 0;
+
+    // Optional latency overlay (DrawLipSyncLatency setting)
+    bool mDrawLatency = false;
+    std::unique_ptr<TextCache> mLatencyText;
+    int mLatencyTextElapsed = 0;
 };
 
 #endif // ES_APP_GUIS_GUI_AI_GRAPHICS_H
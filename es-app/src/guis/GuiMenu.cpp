@@ -720,6 +720,7 @@ void GuiMenu::openDeveloperSettings()
 	s->addSaveFunc([max_vram] { Settings::getInstance()->setInt("MaxVRAM", (int)round(max_vram->getValue())); });
 	
 	s->addSwitch(_("SHOW FRAMERATE"), _("Also turns on the emulator's native FPS counter, if available."), "DrawFramerate", true, nullptr);
+	s->addSwitch(_("SHOW LIP-SYNC LATENCY"), _("Shows the phoneme to face latencies on the AI screen."), "DrawLipSyncLatency", true, nullptr);
 	s->addSwitch(_("VSYNC"), "VSync", true, [] { Renderer::setSwapInterval(); });
 
 #ifdef BATOCERA
@@ -1153,6 +1154,12 @@ void GuiMenu::openDeveloperSettings()
 	s->addWithLabel(_("THREADED LOADING"), threadedLoading);
 	s->addSaveFunc([threadedLoading] { Settings::getInstance()->setBool("ThreadedLoading", threadedLoading->getState()); });
 
+	// library cache
+	auto libraryCache = std::make_shared<SwitchComponent>(mWindow);
+	libraryCache->setState(Settings::getInstance()->getBool("LibraryCache"));
+	s->addWithDescription(_("CACHE GAMELISTS"), _("Loads unchanged systems without scanning their folders and parsing their gamelists"), libraryCache);
+	s->addSaveFunc([libraryCache] { Settings::getInstance()->setBool("LibraryCache", libraryCache->getState()); });
+
 	// threaded loading
 	auto asyncImages = std::make_shared<SwitchComponent>(mWindow);
 	asyncImages->setState(Settings::getInstance()->getBool("AsyncImages"));
@@ -4,6 +4,8 @@
 #include "services/HttpServerThread.h"
 #include "services/HttpApi.h"
 #include "services/LlmStreamService.h"
+#include "services/LlmSocketService.h"
+#include "services/PhonemeReplay.h"
 #include "guis/GuiDetectDevice.h"
 #include "guis/GuiMsgBox.h"
 #include "utils/FileSystemUtil.h"
@@ -53,6 +55,13 @@
 
 static std::string gPlayVideo;
 static int gPlayVideoDuration = 0;
+
+enum class PhonemeTraceMode { NONE, RECORD, REPLAY, BENCHMARK };
+static PhonemeTraceMode gPhonemeTraceMode = PhonemeTraceMode::NONE;
+static std::string gPhonemeTrace;
+static float gPhonemeTraceSpeed = 1.0f;
+static int gPhonemeTraceSeconds = 30;
+static int gPhonemeQueueVersion = 2;
 static bool enable_startup_game = true;
 
 bool parseArgs(int argc, char* argv[])
@@ -88,6 +97,34 @@ bool parseArgs(int argc, char* argv[])
 			gPlayVideo = argv[i + 1];
 			i++; // skip the argument value
 		}
+		else if ((strcmp(argv[i], "--phoneme-record") == 0 || strcmp(argv[i], "--phoneme-replay") == 0 || strcmp(argv[i], "--phoneme-benchmark") == 0) && i < argc - 1)
+		{
+			if (strcmp(argv[i], "--phoneme-record") == 0)
+				gPhonemeTraceMode = PhonemeTraceMode::RECORD;
+			else if (strcmp(argv[i], "--phoneme-replay") == 0)
+				gPhonemeTraceMode = PhonemeTraceMode::REPLAY;
+			else
+				gPhonemeTraceMode = PhonemeTraceMode::BENCHMARK;
+
+			gPhonemeTrace = argv[i + 1];
+			i++; // skip the argument value
+
+			// Optional : speed for replay/benchmark, duration in seconds for record
+			if (i < argc - 1 && argv[i + 1][0] != '-')
+			{
+				if (gPhonemeTraceMode == PhonemeTraceMode::RECORD)
+					gPhonemeTraceSeconds = atoi(argv[i + 1]);
+				else
+					gPhonemeTraceSpeed = (float)atof(argv[i + 1]);
+
+				i++;
+			}
+		}
+		else if (strcmp(argv[i], "--phoneme-queue-version") == 0 && i < argc - 1)
+		{
+			gPhonemeQueueVersion = atoi(argv[i + 1]);
+			i++; // skip the argument value
+		}
 		else if (strcmp(argv[i], "--monitor") == 0)
 		{
 			if (i >= argc - 1)
@@ -253,6 +290,10 @@ bool parseArgs(int argc, char* argv[])
 				"--home [path]		Directory to use as home path\n"
 				"--help, -h			summon a sentient, angry tuba\n\n"
 				"--monitor [index]			monitor index\n\n"				
+				"--phoneme-record [file] [seconds]	record the TTS phoneme queue to a trace file\n"
+				"--phoneme-replay [file] [speed]	play a phoneme trace on the TTS phoneme queue\n"
+				"--phoneme-benchmark [file] [speed]	headless benchmark of the phoneme to face pipeline\n"
+				"--phoneme-queue-version [1/2/3]	queue layout written by replay/benchmark (default 2)\n\n"
 				"More information available in README.md.\n";
 			return false; //exit after printing help
 		}
@@ -509,6 +550,18 @@ int main(int argc, char* argv[])
 		return 0;
 	}
 
+	switch (gPhonemeTraceMode)
+	{
+	case PhonemeTraceMode::RECORD:
+		return PhonemeReplay::record(gPhonemeTrace, "/tts_phoneme_queue", gPhonemeTraceSeconds);
+	case PhonemeTraceMode::REPLAY:
+		return PhonemeReplay::replay(gPhonemeTrace, "/tts_phoneme_queue", gPhonemeTraceSpeed, gPhonemeQueueVersion);
+	case PhonemeTraceMode::BENCHMARK:
+		return PhonemeReplay::benchmark(gPhonemeTrace, gPhonemeTraceSpeed, gPhonemeQueueVersion);
+	default:
+		break;
+	}
+
 	//start the logger
 	Log::init();	
 
@@ -614,9 +667,12 @@ int main(int argc, char* argv[])
 	NetworkThread* nthread = new NetworkThread(&window);
 	HttpServerThread httpServer(&window);
 
-	// Start background phoneme reader from shared memory
+	// Start background phoneme reader from shared memory. The queue is attached whenever the TTS server creates it.
 	LlmStreamService::get().start("/tts_phoneme_queue", [&window](const std::function<void()>& fn){ window.postToUiThread(fn); });
 
+	// Line based JSON socket, for tools which send ARPAbet phonemes and text instead of using the shared memory queue
+	LlmSocketService::get().start("/tmp/local-llm.sock", [&window](const std::function<void()>& fn){ window.postToUiThread(fn); });
+
 	// tts
 	TextToSpeech::getInstance()->enable(Settings::getInstance()->getBool("TTS"), false);
 	
@@ -673,7 +729,8 @@ int main(int argc, char* argv[])
 
 		SDL_Event event;
 
-		bool ps_standby = PowerSaver::getState() && (int) SDL_GetTicks() - ps_time > PowerSaver::getMode();
+		// A screen animating at a low rate lets the loop wait for events between its keyframes right away
+		bool ps_standby = PowerSaver::getState() && ((int) SDL_GetTicks() - ps_time > PowerSaver::getMode() || PowerSaver::hasKeyframe());
 		if(ps_standby ? SDL_WaitEventTimeout(&event, PowerSaver::getTimeout()) : SDL_PollEvent(&event))
 		{
 			// PowerSaver can push events to exit SDL_WaitEventTimeout immediatly
@@ -24,6 +24,7 @@
 #include "scrapers/ThreadedScraper.h"
 #include "guis/GuiUpdate.h"
 #include "ContentInstaller.h"
+#include "LipSyncStats.h"
 
 /* 
 
@@ -39,6 +40,7 @@ POST /notify													-> body must contain the message text as text/plain
 POST /launch													-> body must contain the exact file path as text/plain
 GET  /runningGame
 GET  /isIdle
+GET  /lipsync/latency											-> lip-sync latency histograms (p50/p95/p99). ?reset=true clears them
 
 System/Games APIS
 -----------------
@@ -307,6 +309,17 @@ void HttpServerThread::run()
 		}
 	});	
 
+	mHttpServer->Get("/lipsync/latency", [](const httplib::Request& req, httplib::Response& res)
+	{
+		if (!isAllowed(req, res))
+			return;
+
+		res.set_content(LipSyncStats::get().toJson(), "application/json");
+
+		if (req.has_param("reset") && req.get_param_value("reset") == "true")
+			LipSyncStats::get().reset();
+	});
+
 	mHttpServer->Get(R"(/systems/(/?.*)/logo)", [](const httplib::Request& req, httplib::Response& res)
 	{		
 		if (!isAllowed(req, res))
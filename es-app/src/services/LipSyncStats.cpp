@@ -0,0 +1,205 @@
+#include "LipSyncStats.h"
+
+#include <rapidjson/rapidjson.h>
+#include <rapidjson/prettywriter.h>
+#include <rapidjson/stringbuffer.h>
+#include <algorithm>
+#include <iomanip>
+#include <sstream>
+
+static const char* STAGE_NAMES[LipSyncStats::STAGE_COUNT] = {
+    "producer_to_dequeue",
+    "dequeue_to_post",
+    "post_to_dispatch",
+    "schedule_to_render",
+    "producer_to_render"
+};
+
+static const char* COUNTER_NAMES[LipSyncStats::COUNTER_COUNT] = {
+    "queue_overruns",
+    "skipped_phonemes",
+    "dropped_phonemes",
+    "high_water_marks"
+};
+
+LipSyncStats& LipSyncStats::get()
+{
+    static LipSyncStats instance;
+    return instance;
+}
+
+const char* LipSyncStats::getStageName(Stage stage)
+{
+    return stage >= 0 && stage < STAGE_COUNT ? STAGE_NAMES[stage] : "";
+}
+
+const char* LipSyncStats::getCounterName(Counter counter)
+{
+    return counter >= 0 && counter < COUNTER_COUNT ? COUNTER_NAMES[counter] : "";
+}
+
+int LipSyncStats::getBucket(std::uint64_t value)
+{
+    if (value < LINEAR_BUCKETS)
+        return (int)value;
+
+    int exponent = 63 - __builtin_clzll(value);
+    int sub = (int)((value >> (exponent - 2)) & (SUB_BUCKETS - 1));
+    return LINEAR_BUCKETS + (exponent - 4) * SUB_BUCKETS + sub;
+}
+
+std::uint64_t LipSyncStats::getBucketValue(int bucket)
+{
+    if (bucket < LINEAR_BUCKETS)
+        return (std::uint64_t)bucket;
+
+    int exponent = (bucket - LINEAR_BUCKETS) / SUB_BUCKETS + 4;
+    std::uint64_t sub = (std::uint64_t)((bucket - LINEAR_BUCKETS) % SUB_BUCKETS);
+    std::uint64_t width = 1ULL << (exponent - 2);
+
+    // Middle of the bucket
+    return (SUB_BUCKETS + sub) * width + width / 2;
+}
+
+void LipSyncStats::record(Stage stage, std::uint64_t fromUs, std::uint64_t toUs)
+{
+    if (stage < 0 || stage >= STAGE_COUNT || fromUs == 0 || toUs < fromUs)
+        return;
+
+    std::uint64_t value = toUs - fromUs;
+    if (value > MAX_LATENCY_US)
+        return;
+
+    Histogram& histogram = mHistograms[stage];
+    histogram.buckets[getBucket(value)].fetch_add(1, std::memory_order_relaxed);
+    histogram.count.fetch_add(1, std::memory_order_relaxed);
+
+    std::uint64_t max = histogram.max.load(std::memory_order_relaxed);
+    while (value > max && !histogram.max.compare_exchange_weak(max, value, std::memory_order_relaxed)) {}
+}
+
+std::uint64_t LipSyncStats::getCount(Stage stage) const
+{
+    return mHistograms[stage].count.load(std::memory_order_relaxed);
+}
+
+std::uint64_t LipSyncStats::getMax(Stage stage) const
+{
+    return mHistograms[stage].max.load(std::memory_order_relaxed);
+}
+
+std::uint64_t LipSyncStats::getPercentile(Stage stage, double percentile) const
+{
+    const Histogram& histogram = mHistograms[stage];
+
+    // Sum the buckets rather than using 'count' : both are updated without a common lock
+    std::uint64_t total = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++)
+        total += histogram.buckets[i].load(std::memory_order_relaxed);
+
+    if (total == 0)
+        return 0;
+
+    std::uint64_t rank = (std::uint64_t)(percentile / 100.0 * (double)total + 0.5);
+    if (rank < 1)
+        rank = 1;
+
+    std::uint64_t seen = 0;
+    for (int i = 0; i < BUCKET_COUNT; i++)
+    {
+        seen += histogram.buckets[i].load(std::memory_order_relaxed);
+        if (seen >= rank)
+            return std::min(getBucketValue(i), getMax(stage));
+    }
+
+    return getMax(stage);
+}
+
+void LipSyncStats::count(Counter counter, std::uint64_t value)
+{
+    if (counter >= 0 && counter < COUNTER_COUNT)
+        mCounters[counter].fetch_add(value, std::memory_order_relaxed);
+}
+
+std::uint64_t LipSyncStats::getCounter(Counter counter) const
+{
+    return mCounters[counter].load(std::memory_order_relaxed);
+}
+
+void LipSyncStats::reset()
+{
+    for (auto& histogram : mHistograms)
+    {
+        for (auto& bucket : histogram.buckets)
+            bucket.store(0, std::memory_order_relaxed);
+
+        histogram.count.store(0, std::memory_order_relaxed);
+        histogram.max.store(0, std::memory_order_relaxed);
+    }
+
+    for (auto& counter : mCounters)
+        counter.store(0, std::memory_order_relaxed);
+}
+
+std::string LipSyncStats::toJson() const
+{
+    rapidjson::StringBuffer s;
+    rapidjson::PrettyWriter<rapidjson::StringBuffer> writer(s);
+
+    writer.StartObject();
+
+    for (int i = 0; i < STAGE_COUNT; i++)
+    {
+        Stage stage = (Stage)i;
+
+        writer.Key(getStageName(stage));
+        writer.StartObject();
+        writer.Key("count"); writer.Uint64(getCount(stage));
+        writer.Key("p50_us"); writer.Uint64(getPercentile(stage, 50));
+        writer.Key("p95_us"); writer.Uint64(getPercentile(stage, 95));
+        writer.Key("p99_us"); writer.Uint64(getPercentile(stage, 99));
+        writer.Key("max_us"); writer.Uint64(getMax(stage));
+        writer.EndObject();
+    }
+
+    writer.Key("counters");
+    writer.StartObject();
+
+    for (int i = 0; i < COUNTER_COUNT; i++)
+    {
+        writer.Key(getCounterName((Counter)i));
+        writer.Uint64(getCounter((Counter)i));
+    }
+
+    writer.EndObject();
+
+    writer.EndObject();
+
+    return s.GetString();
+}
+
+std::string LipSyncStats::toOverlayText() const
+{
+    std::stringstream ss;
+    ss << std::fixed << std::setprecision(1);
+    ss << "Lip-sync latency (ms) p50 / p95 / p99";
+
+    for (int i = 0; i < STAGE_COUNT; i++)
+    {
+        Stage stage = (Stage)i;
+
+        ss << "\n" << getStageName(stage) << ": ";
+        if (getCount(stage) == 0)
+        {
+            ss << "-";
+            continue;
+        }
+
+        ss << getPercentile(stage, 50) / 1000.0f << " / " << getPercentile(stage, 95) / 1000.0f << " / " << getPercentile(stage, 99) / 1000.0f;
+    }
+
+    ss << "\noverruns: " << getCounter(QUEUE_OVERRUNS) << ", skipped: " << getCounter(SKIPPED_PHONEMES)
+       << ", dropped: " << getCounter(DROPPED_PHONEMES) << ", high-water: " << getCounter(HIGH_WATER_MARKS);
+
+    return ss.str();
+}
@@ -0,0 +1,79 @@
+#pragma once
+#ifndef ES_APP_SERVICES_LIP_SYNC_STATS_H
+#define ES_APP_SERVICES_LIP_SYNC_STATS_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+// Latency histograms of the phoneme -> face pipeline, fed from the reader thread and the UI thread.
+// All times are steady clock microseconds. Producer timestamps are only usable when the TTS server stamps
+// phonemes with CLOCK_MONOTONIC : intervals which are negative or longer than MAX_LATENCY_US are ignored.
+class LipSyncStats
+{
+public:
+    enum Stage
+    {
+        PRODUCER_TO_DEQUEUE = 0, // producer timestamp_us -> read from shared memory
+        DEQUEUE_TO_POST,         // read from shared memory -> posted to the UI thread
+        POST_TO_DISPATCH,        // posted -> run by Window::processPostedFunctions
+        SCHEDULE_TO_RENDER,      // scheduled presentation time -> first frame rendered with the face
+        PRODUCER_TO_RENDER,      // producer timestamp_us -> first frame rendered with the face
+        STAGE_COUNT
+    };
+
+    // Events of the shared memory queue, counted rather than timed
+    enum Counter
+    {
+        QUEUE_OVERRUNS = 0,  // producer lapped the reader (v3 sequence numbers)
+        SKIPPED_PHONEMES,    // unread phonemes skipped to catch up with the producer after an overrun
+        DROPPED_PHONEMES,    // phonemes dropped because the UI thread did not keep up
+        HIGH_WATER_MARKS,    // times the queue went above its high-water mark
+        COUNTER_COUNT
+    };
+
+    static constexpr std::uint64_t MAX_LATENCY_US = 10000000;
+
+    static LipSyncStats& get();
+    static const char* getStageName(Stage stage);
+    static const char* getCounterName(Counter counter);
+
+    // Thread safe, lock free
+    void record(Stage stage, std::uint64_t fromUs, std::uint64_t toUs);
+
+    std::uint64_t getCount(Stage stage) const;
+    std::uint64_t getMax(Stage stage) const;
+    std::uint64_t getPercentile(Stage stage, double percentile) const;
+
+    void count(Counter counter, std::uint64_t value = 1);
+    std::uint64_t getCounter(Counter counter) const;
+
+    void reset();
+
+    std::string toJson() const;
+    std::string toOverlayText() const;
+
+private:
+    LipSyncStats() = default;
+
+    // Log-linear buckets : exact below 16us, then 4 buckets per power of two (<= 25% error)
+    static constexpr int LINEAR_BUCKETS = 16;
+    static constexpr int SUB_BUCKETS = 4;
+    static constexpr int BUCKET_COUNT = LINEAR_BUCKETS + (64 - 4) * SUB_BUCKETS;
+
+    static int getBucket(std::uint64_t value);
+    static std::uint64_t getBucketValue(int bucket);
+
+    struct Histogram
+    {
+        std::atomic<std::uint64_t> buckets[BUCKET_COUNT];
+        std::atomic<std::uint64_t> count;
+        std::atomic<std::uint64_t> max;
+    };
+
+    Histogram mHistograms[STAGE_COUNT] = {};
+    std::atomic<std::uint64_t> mCounters[COUNTER_COUNT] = {};
+};
+
+#endif // ES_APP_SERVICES_LIP_SYNC_STATS_H
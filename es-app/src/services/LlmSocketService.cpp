@@ -0,0 +1,463 @@
+#include "LlmSocketService.h"
+#include "LipSyncStats.h"
+
+#include <rapidjson/document.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cctype>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+static const int MAX_EVENTS = 32;
+static const size_t INITIAL_BUFFER_SIZE = 4096;
+
+// ARPAbet inventory of the CMU dictionary, phoneme id = ARPABET_PHONEME_ID_BASE + index. Pauses are "SIL", "SP" or "_".
+static const char* ARPABET_SYMBOLS[] = {
+    "SIL",
+    "AA", "AE", "AH", "AO", "AW", "AY",
+    "B", "CH", "D", "DH",
+    "EH", "ER", "EY",
+    "F", "G", "HH",
+    "IH", "IY",
+    "JH", "K", "L", "M", "N", "NG",
+    "OW", "OY",
+    "P", "R", "S", "SH", "T", "TH",
+    "UH", "UW",
+    "V", "W", "Y", "Z", "ZH"
+};
+
+// Documents are parsed with these stack buffers : no heap allocation for usual lines
+typedef rapidjson::GenericDocument<rapidjson::UTF8<>, rapidjson::MemoryPoolAllocator<>, rapidjson::MemoryPoolAllocator<>> LineDocument;
+static const size_t VALUE_BUFFER_SIZE = 16384;
+static const size_t PARSE_BUFFER_SIZE = 2048;
+
+LlmSocketService& LlmSocketService::get()
+{
+    static LlmSocketService instance;
+    return instance;
+}
+
+LlmSocketService::~LlmSocketService()
+{
+    stop();
+}
+
+int LlmSocketService::arpabetToPhonemeId(const char* symbol, size_t length)
+{
+    // Stress markers : AH0, AH1, AH2
+    while (length > 0 && isdigit((unsigned char)symbol[length - 1]))
+        length--;
+
+    if (length == 0 || length > 3)
+        return -1;
+
+    char upper[4] = { 0 };
+    for (size_t i = 0; i < length; i++)
+        upper[i] = (char)toupper((unsigned char)symbol[i]);
+
+    if (strcmp(upper, "_") == 0 || strcmp(upper, "SP") == 0 || strcmp(upper, "SPN") == 0)
+        return ARPABET_PHONEME_ID_BASE;
+
+    for (size_t i = 0; i < sizeof(ARPABET_SYMBOLS) / sizeof(ARPABET_SYMBOLS[0]); i++)
+        if (strcmp(upper, ARPABET_SYMBOLS[i]) == 0)
+            return ARPABET_PHONEME_ID_BASE + (int)i;
+
+    return -1;
+}
+
+void LlmSocketService::start(const std::string& socketPath, UiPoster uiPoster)
+{
+    stop();
+
+    mSocketPath = socketPath.empty() ? std::string("/tmp/local-llm.sock") : socketPath;
+    mUiPoster = uiPoster;
+
+    // Preallocate the UI side of the hand-off so that dispatching never allocates
+    mUiBatch.resize(PHONEME_RING_SIZE);
+    mDispatchFn = [this]() { dispatch(); };
+
+    if (!openSocket())
+    {
+        closeSocket();
+        return;
+    }
+
+    mRunning = true;
+    mThread = std::thread(&LlmSocketService::run, this);
+}
+
+void LlmSocketService::stop()
+{
+    if (mRunning.exchange(false))
+    {
+        std::uint64_t value = 1;
+        if (write(mWakeFd, &value, sizeof(value)) < 0) {}
+
+        if (mThread.joinable())
+            mThread.join();
+    }
+
+    closeSocket();
+
+    mRing.clear();
+    mDispatchPending = false;
+}
+
+bool LlmSocketService::openSocket()
+{
+    struct sockaddr_un addr;
+    if (mSocketPath.size() >= sizeof(addr.sun_path))
+    {
+        std::cerr << "[LlmSocketService] Socket path too long: " << mSocketPath << std::endl;
+        return false;
+    }
+
+    mEpollFd = epoll_create1(EPOLL_CLOEXEC);
+    mWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    mListenFd = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+
+    if (mEpollFd < 0 || mWakeFd < 0 || mListenFd < 0)
+    {
+        std::cerr << "[LlmSocketService] Failed to create socket: " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, mSocketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    // Left over by a previous run
+    unlink(mSocketPath.c_str());
+
+    if (bind(mListenFd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(mListenFd, 16) < 0)
+    {
+        std::cerr << "[LlmSocketService] Failed to listen on " << mSocketPath << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    struct epoll_event ev;
+    memset(&ev, 0, sizeof(ev));
+    ev.events = EPOLLIN;
+
+    ev.data.fd = mListenFd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mListenFd, &ev);
+
+    ev.data.fd = mWakeFd;
+    epoll_ctl(mEpollFd, EPOLL_CTL_ADD, mWakeFd, &ev);
+
+    std::cout << "[LlmSocketService] Listening on " << mSocketPath << std::endl;
+    return true;
+}
+
+void LlmSocketService::closeSocket()
+{
+    for (auto& client : mClients)
+        close(client.first);
+
+    mClients.clear();
+
+    if (mListenFd >= 0)
+    {
+        close(mListenFd);
+        mListenFd = -1;
+        unlink(mSocketPath.c_str());
+    }
+
+    if (mEpollFd >= 0)
+    {
+        close(mEpollFd);
+        mEpollFd = -1;
+    }
+
+    if (mWakeFd >= 0)
+    {
+        close(mWakeFd);
+        mWakeFd = -1;
+    }
+}
+
+void LlmSocketService::run()
+{
+    struct epoll_event events[MAX_EVENTS];
+
+    while (mRunning.load())
+    {
+        int count = epoll_wait(mEpollFd, events, MAX_EVENTS, -1);
+        if (count < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            std::cerr << "[LlmSocketService] epoll_wait failed: " << strerror(errno) << std::endl;
+            break;
+        }
+
+        mPushed = false;
+
+        for (int i = 0; i < count; i++)
+        {
+            int fd = events[i].data.fd;
+
+            if (fd == mWakeFd)
+            {
+                std::uint64_t value;
+                while (read(mWakeFd, &value, sizeof(value)) > 0) {}
+                continue;
+            }
+
+            if (fd == mListenFd)
+            {
+                acceptClients();
+                continue;
+            }
+
+            auto it = mClients.find(fd);
+            if (it != mClients.cend() && !readClient(fd, it->second))
+                closeClient(fd);
+        }
+
+        // One UI wake-up for everything read by this round
+        if (mPushed && mUiPoster && !mDispatchPending.exchange(true))
+            mUiPoster(mDispatchFn);
+    }
+}
+
+void LlmSocketService::acceptClients()
+{
+    for (;;)
+    {
+        int fd = accept4(mListenFd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC);
+        if (fd < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            if (errno != EAGAIN && errno != EWOULDBLOCK)
+                std::cerr << "[LlmSocketService] accept failed: " << strerror(errno) << std::endl;
+
+            return;
+        }
+
+        if (mClients.size() >= MAX_CLIENTS)
+        {
+            std::cerr << "[LlmSocketService] Too many clients, refusing connection" << std::endl;
+            close(fd);
+            continue;
+        }
+
+        struct epoll_event ev;
+        memset(&ev, 0, sizeof(ev));
+        ev.events = EPOLLIN | EPOLLRDHUP;
+        ev.data.fd = fd;
+
+        if (epoll_ctl(mEpollFd, EPOLL_CTL_ADD, fd, &ev) < 0)
+        {
+            close(fd);
+            continue;
+        }
+
+        Client& client = mClients[fd];
+        client.buffer.resize(INITIAL_BUFFER_SIZE);
+        client.length = 0;
+        client.discarding = false;
+    }
+}
+
+void LlmSocketService::closeClient(int fd)
+{
+    epoll_ctl(mEpollFd, EPOLL_CTL_DEL, fd, nullptr);
+    close(fd);
+    mClients.erase(fd);
+}
+
+bool LlmSocketService::readClient(int fd, Client& client)
+{
+    for (;;)
+    {
+        // Keep room for the terminator of a line which fills the buffer
+        if (client.length + 1 >= client.buffer.size())
+        {
+            if (client.buffer.size() > MAX_LINE_LENGTH)
+            {
+                std::cerr << "[LlmSocketService] Line longer than " << MAX_LINE_LENGTH << " bytes, skipping it" << std::endl;
+                client.discarding = true;
+                client.length = 0;
+            }
+            else
+                client.buffer.resize(std::min(client.buffer.size() * 2, MAX_LINE_LENGTH + 2));
+        }
+
+        char* data = client.buffer.data();
+        ssize_t len = read(fd, data + client.length, client.buffer.size() - 1 - client.length);
+        if (len == 0)
+            return false;
+
+        if (len < 0)
+        {
+            if (errno == EINTR)
+                continue;
+
+            return errno == EAGAIN || errno == EWOULDBLOCK;
+        }
+
+        char* lineStart = data;
+        char* scan = data + client.length;
+        char* end = scan + len;
+
+        char* newline;
+        while ((newline = (char*)memchr(scan, '\n', end - scan)) != nullptr)
+        {
+            *newline = '\0';
+
+            if (client.discarding)
+                client.discarding = false;
+            else
+                processLine(lineStart);
+
+            lineStart = scan = newline + 1;
+        }
+
+        if (client.discarding)
+            client.length = 0;
+        else
+        {
+            client.length = end - lineStart;
+            if (lineStart != data && client.length > 0)
+                memmove(data, lineStart, client.length);
+        }
+    }
+}
+
+void LlmSocketService::processLine(char* line)
+{
+    while (isspace((unsigned char)*line))
+        line++;
+
+    if (*line == '\0')
+        return;
+
+    char valueBuffer[VALUE_BUFFER_SIZE];
+    char parseBuffer[PARSE_BUFFER_SIZE];
+    rapidjson::MemoryPoolAllocator<> valueAllocator(valueBuffer, sizeof(valueBuffer));
+    rapidjson::MemoryPoolAllocator<> parseAllocator(parseBuffer, sizeof(parseBuffer));
+    LineDocument doc(&valueAllocator, sizeof(parseBuffer), &parseAllocator);
+
+    // Strings of the document point into 'line'
+    if (doc.ParseInsitu(line).HasParseError() || !doc.IsObject())
+    {
+        std::cerr << "[LlmSocketService] Ignoring invalid JSON line" << std::endl;
+        return;
+    }
+
+    auto message = doc.FindMember("message");
+    if (message != doc.MemberEnd() && message->value.IsString())
+    {
+        std::lock_guard<std::mutex> lock(mTranscriptMutex);
+        mTranscripts.emplace_back(message->value.GetString(), message->value.GetStringLength());
+        mTranscripts.back() += '\n';
+        mPushed = true;
+    }
+
+    auto token = doc.FindMember("token");
+    if (token != doc.MemberEnd() && token->value.IsString())
+    {
+        std::lock_guard<std::mutex> lock(mTranscriptMutex);
+        mTranscripts.emplace_back(token->value.GetString(), token->value.GetStringLength());
+        mPushed = true;
+    }
+
+    auto phoneme = doc.FindMember("phoneme");
+    if (phoneme != doc.MemberEnd() && phoneme->value.IsString())
+    {
+        auto duration = doc.FindMember("durationMs");
+        pushPhoneme(phoneme->value.GetString(), phoneme->value.GetStringLength(),
+            duration != doc.MemberEnd() && duration->value.IsNumber() ? duration->value.GetDouble() : 0);
+    }
+
+    auto phonemes = doc.FindMember("phonemes");
+    if (phonemes != doc.MemberEnd() && phonemes->value.IsString())
+    {
+        auto durations = doc.FindMember("phonemeDurations");
+        bool hasDurations = durations != doc.MemberEnd() && durations->value.IsArray();
+
+        const char* ptr = phonemes->value.GetString();
+        const char* end = ptr + phonemes->value.GetStringLength();
+        rapidjson::SizeType index = 0;
+
+        while (ptr < end)
+        {
+            while (ptr < end && isspace((unsigned char)*ptr))
+                ptr++;
+
+            const char* symbol = ptr;
+            while (ptr < end && !isspace((unsigned char)*ptr))
+                ptr++;
+
+            if (ptr == symbol)
+                break;
+
+            double durationMs = 0;
+            if (hasDurations && index < durations->value.Size() && durations->value[index].IsNumber())
+                durationMs = durations->value[index].GetDouble();
+
+            pushPhoneme(symbol, ptr - symbol, durationMs);
+            index++;
+        }
+    }
+}
+
+void LlmSocketService::pushPhoneme(const char* symbol, size_t length, double durationMs)
+{
+    int id = arpabetToPhonemeId(symbol, length);
+    if (id < 0)
+    {
+        // Keep the timing : an unknown symbol holds the mouth like a pause
+        if (mUnknownSymbols.insert(std::string(symbol, length)).second)
+            std::cerr << "[LlmSocketService] Unknown ARPAbet symbol " << std::string(symbol, length) << std::endl;
+        id = ARPABET_PHONEME_ID_BASE;
+    }
+
+    if (durationMs <= 0 || durationMs > 10000)
+        durationMs = DEFAULT_PHONEME_DURATION_MS;
+
+    PhonemeData data;
+    data.phoneme_id = id;
+    data.duration_seconds = (float)(durationMs / 1000.0);
+    data.sequence = 0;
+    data.timestamp_us = 0; // arrival time is not a presentation time : the durations are chained
+
+    if (mRing.push(data))
+        mPushed = true;
+    else
+    {
+        LipSyncStats::get().count(LipSyncStats::DROPPED_PHONEMES);
+        if (mDroppedPhonemes++ == 0)
+            std::cerr << "[LlmSocketService] UI is not keeping up, dropping phonemes" << std::endl;
+    }
+}
+
+void LlmSocketService::dispatch()
+{
+    // Reset first : anything pushed from now on posts a new dispatch
+    mDispatchPending = false;
+
+    size_t count = mRing.pop(mUiBatch.data(), mUiBatch.size());
+
+    {
+        std::lock_guard<std::mutex> lock(mTranscriptMutex);
+        mUiTranscripts.swap(mTranscripts);
+    }
+
+    for (auto& text : mUiTranscripts)
+        LlmStreamService::get().deliverTranscript(text);
+
+    mUiTranscripts.clear();
+
+    LlmStreamService::get().deliverPhonemes(mUiBatch.data(), count);
+}
@@ -0,0 +1,100 @@
+#pragma once
+#ifndef ES_APP_SERVICES_LLM_SOCKET_SERVICE_H
+#define ES_APP_SERVICES_LLM_SOCKET_SERVICE_H
+
+#include "LlmStreamService.h"
+#include "utils/SpscRing.h"
+#include <atomic>
+#include <cstddef>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+// Unix socket server for tools which drive the face without the shared memory producer (test-llm-server.py...).
+// Clients send newline delimited JSON objects :
+//   {"message": "Hello"}                                          transcript line
+//   {"token": " wor"}                                             transcript text streamed as is (LLM tokens)
+//   {"phoneme": "HH", "durationMs": 100}                          one phoneme
+//   {"phonemes": "HH EH L OW", "phonemeDurations": [80, 100, 90, 120]}
+// Phonemes are ARPAbet symbols (stress digits are ignored). They are converted to phoneme ids in the
+// ARPABET_PHONEME_ID_BASE range, so the viseme maps give their mouth shapes like for any other voice, and are
+// handed to the LlmStreamService subscribers. A single thread serves all clients with epoll : every line read
+// in one wake-up is parsed in place in the client buffer, then the UI thread is woken once for the whole batch.
+class LlmSocketService
+{
+public:
+    using UiPoster = std::function<void(const std::function<void()>&)>;
+    using PhonemeData = LlmStreamService::PhonemeData;
+
+    static constexpr int ARPABET_PHONEME_ID_BASE = 1000;
+    static constexpr int DEFAULT_PHONEME_DURATION_MS = 100;
+    static constexpr size_t MAX_CLIENTS = 32;
+    static constexpr size_t MAX_LINE_LENGTH = 65536;
+
+    static LlmSocketService& get();
+
+    // Phoneme id of an ARPAbet symbol ("SIL", "AA", "AH0"...), -1 if unknown
+    static int arpabetToPhonemeId(const char* symbol, size_t length);
+
+    void start(const std::string& socketPath, UiPoster uiPoster);
+    void stop();
+
+private:
+    LlmSocketService() = default;
+    ~LlmSocketService();
+
+    struct Client
+    {
+        std::vector<char> buffer;
+        size_t length = 0;
+        bool discarding = false; // skipping the rest of a line longer than MAX_LINE_LENGTH
+    };
+
+    void run();
+
+    bool openSocket();
+    void closeSocket();
+    void acceptClients();
+    // Returns false when the client is gone
+    bool readClient(int fd, Client& client);
+    void closeClient(int fd);
+
+    // 'line' is NUL terminated and modified by the in situ parser
+    void processLine(char* line);
+    void pushPhoneme(const char* symbol, size_t length, double durationMs);
+
+    // UI thread
+    void dispatch();
+
+    std::thread mThread;
+    std::atomic<bool> mRunning{false};
+    std::string mSocketPath;
+    UiPoster mUiPoster;
+
+    int mListenFd{-1};
+    int mEpollFd{-1};
+    int mWakeFd{-1};
+    std::unordered_map<int, Client> mClients;
+
+    // Server thread -> UI thread hand-off. At most one dispatch is posted at a time.
+    static constexpr size_t PHONEME_RING_SIZE = 1024;
+    Utils::SpscRing<PhonemeData, PHONEME_RING_SIZE> mRing;
+    std::vector<PhonemeData> mUiBatch;
+    std::function<void()> mDispatchFn;
+    std::atomic<bool> mDispatchPending{false};
+    bool mPushed{false};
+
+    // Server thread : log each problem once, LipSyncStats counts the drops
+    std::uint32_t mDroppedPhonemes{0};
+    std::unordered_set<std::string> mUnknownSymbols;
+
+    std::mutex mTranscriptMutex;
+    std::vector<std::string> mTranscripts;
+    std::vector<std::string> mUiTranscripts;
+};
+
+#endif // ES_APP_SERVICES_LLM_SOCKET_SERVICE_H
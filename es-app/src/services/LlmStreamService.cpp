@@ -1,18 +1,92 @@
 #include "LlmStreamService.h"
+#include "LipSyncStats.h"
+#include "VisemeScheduler.h"
 
 #include <sys/mman.h>
 #include <sys/stat.h>
-#include <sys/socket.h>
-#include <sys/un.h>
+#include <sys/syscall.h>
+#include <sys/eventfd.h>
+#include <sys/inotify.h>
+#include <poll.h>
+#include <linux/futex.h>
 #include <fcntl.h>
+#include <climits>
+#include <ctime>
 #include <unistd.h>
 #include <cstring>
+#include <cctype>
 #include <algorithm>
 #include <iostream>
 #include <cerrno>
 #include <chrono>
 #include <thread>
 
+// The reader wakes up at least this often to check it is still running
+static const int READER_WAIT_TIMEOUT_MS = 500;
+
+// Retry delay while the producer has created the queue but not initialized it yet
+static const int QUEUE_INIT_RETRY_MS = 20;
+
+// While waiting on the doorbells, the queues which do not exist yet are looked for at this rate
+static const int QUEUE_PROBE_MS = 100;
+
+// Polling period when several queues can not be waited on together (v1 semaphores, kernels without futex_waitv)
+static const int MULTIPLEX_POLL_MS = 5;
+
+static const size_t MAX_SESSION_NAME_LENGTH = 64;
+
+#ifndef SYS_futex_waitv
+#define SYS_futex_waitv 449
+#endif
+
+// struct futex_waitv of <linux/futex.h>, which older kernel headers do not have
+struct FutexWaitv
+{
+    std::uint64_t val;
+    std::uint64_t uaddr;
+    std::uint32_t flags;
+    std::uint32_t reserved;
+};
+
+static const std::uint32_t FUTEX_WAITV_SIZE_U32 = 0x02; // FUTEX_32
+
+// Shared (not FUTEX_PRIVATE) operations : the doorbell word lives in memory mapped by the producer process too
+static void futexWait(std::atomic<std::uint32_t>* addr, std::uint32_t expected, int timeoutMs)
+{
+    struct timespec ts;
+    ts.tv_sec = timeoutMs / 1000;
+    ts.tv_nsec = (timeoutMs % 1000) * 1000000L;
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(addr), FUTEX_WAIT, expected, &ts, nullptr, 0);
+}
+
+static void futexWake(std::atomic<std::uint32_t>* addr)
+{
+    syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(addr), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+}
+
+// Waits until any of the words differs from its expected value. Returns false if the kernel has no
+// futex_waitv (before Linux 5.16).
+static bool futexWaitv(FutexWaitv* waiters, unsigned int count, int timeoutMs)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    ts.tv_nsec += (timeoutMs % 1000) * 1000000L;
+    ts.tv_sec += timeoutMs / 1000 + ts.tv_nsec / 1000000000L;
+    ts.tv_nsec %= 1000000000L;
+
+    return syscall(SYS_futex_waitv, waiters, count, 0, &ts, CLOCK_MONOTONIC) >= 0 || errno != ENOSYS;
+}
+
+static FutexWaitv futexWaiter(std::atomic<std::uint32_t>* addr, std::uint32_t expected)
+{
+    FutexWaitv waiter;
+    waiter.val = expected;
+    waiter.uaddr = (std::uint64_t)(uintptr_t)addr;
+    waiter.flags = FUTEX_WAITV_SIZE_U32;
+    waiter.reserved = 0;
+    return waiter;
+}
+
 LlmStreamService& LlmStreamService::get()
 {
     static LlmStreamService instance;
@@ -22,6 +96,13 @@ LlmStreamService& LlmStreamService::get()
 LlmStreamService::~LlmStreamService()
 {
     stop();
+
+    delete mSubscribers.exchange(nullptr);
+
+    for (auto subs : mRetiredSubscribers)
+        delete subs;
+
+    mRetiredSubscribers.clear();
 }
 
 void LlmStreamService::start(const std::string& shmPath, UiPoster uiPoster)
@@ -29,177 +110,917 @@ void LlmStreamService::start(const std::string& shmPath, UiPoster uiPoster)
     stop();
     mShmPath = shmPath.empty() ? std::string("/tts_phoneme_queue") : shmPath;
     mUiPoster = uiPoster;
-    
-    // Open shared memory
-    std::string fullPath = "/dev/shm" + mShmPath;
-    mShmFd = open(fullPath.c_str(), O_RDWR);
-    if (mShmFd < 0) {
-        std::cerr << "[LlmStreamService] Failed to open shared memory at " << fullPath 
-                  << ": " << strerror(errno) << std::endl;
-        std::cerr << "[LlmStreamService] Make sure TTS server is running" << std::endl;
-        return;
-    }
-    
-    // Get size of shared memory
-    struct stat sb;
-    if (fstat(mShmFd, &sb) == -1) {
-        std::cerr << "[LlmStreamService] Failed to get shared memory size: " << strerror(errno) << std::endl;
-        close(mShmFd);
-        mShmFd = -1;
-        return;
+
+    // Preallocate the UI side of the hand-off so that dispatching never allocates
+    mUiQueued.resize(PHONEME_RING_SIZE);
+    mUiBatch.resize(PHONEME_RING_SIZE);
+
+    // The default session is always read. Sessions opened before start() follow the new path.
+    getSession(std::string());
+
+    size_t count = mSessionCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++)
+    {
+        mSessions[i]->shmPath = getQueuePath(*mSessions[i]);
+        mSessions[i]->nextProbeUs = 0;
     }
-    
-    // Map shared memory
-    mSharedMem = mmap(nullptr, sb.st_size, PROT_READ | PROT_WRITE, MAP_SHARED, mShmFd, 0);
-    if (mSharedMem == MAP_FAILED) {
-        std::cerr << "[LlmStreamService] Failed to map shared memory: " << strerror(errno) << std::endl;
-        close(mShmFd);
-        mShmFd = -1;
-        mSharedMem = nullptr;
-        return;
+
+    // Lets stop() interrupt the reader while it waits for a queue to appear
+    mWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+
+    // Watch /dev/shm so that the queues are attached as soon as the TTS server creates them, and so that a
+    // producer recreating one is noticed. If inotify is not available, the reader still probes periodically.
+    mInotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (mInotifyFd >= 0 && inotify_add_watch(mInotifyFd, "/dev/shm", IN_CREATE | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM) < 0)
+    {
+        close(mInotifyFd);
+        mInotifyFd = -1;
     }
-    
-    // Read initial read_index from shared memory
-    auto* queue = static_cast<LlmStreamService::PhonemeSharedQueue*>(mSharedMem);
-    mConsumerReadIndex = queue->header.read_index.load(std::memory_order_relaxed);
-    
+
+    mControlChannel.start(mControlSocketPath, uiPoster);
+
+    // Attaching is done by the reader thread : ES startup never waits for the TTS server
     mRunning = true;
     mThread = std::thread(&LlmStreamService::phonemeReaderThread, this);
-    
-    std::cout << "[LlmStreamService] Connected to phoneme queue at " << fullPath << std::endl;
 }
 
 void LlmStreamService::stop()
 {
+    mControlChannel.stop();
+
     if (!mRunning.load())
         return;
     mRunning = false;
+    wakeReader();
     if (mThread.joinable())
         mThread.join();
-    
-    if (mSharedMem && mSharedMem != MAP_FAILED) {
-        munmap(mSharedMem, sizeof(LlmStreamService::PhonemeSharedQueue));
-        mSharedMem = nullptr;
+
+    if (mInotifyFd >= 0) {
+        close(mInotifyFd);
+        mInotifyFd = -1;
+    }
+
+    if (mWakeFd >= 0) {
+        close(mWakeFd);
+        mWakeFd = -1;
+    }
+
+    size_t count = mSessionCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++)
+    {
+        mSessions[i]->ring.clear();
+        mSessions[i]->dispatchPending = false;
+    }
+}
+
+bool LlmStreamService::isValidSessionName(const std::string& session)
+{
+    if (session.length() > MAX_SESSION_NAME_LENGTH)
+        return false;
+
+    for (auto c : session)
+        if (!isalnum((unsigned char)c) && c != '_' && c != '-')
+            return false;
+
+    return true;
+}
+
+LlmStreamService::Session* LlmStreamService::findSession(const std::string& session) const
+{
+    size_t count = mSessionCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++)
+        if (mSessions[i]->name == session)
+            return mSessions[i].get();
+
+    return nullptr;
+}
+
+LlmStreamService::Session* LlmStreamService::getSession(const std::string& session)
+{
+    std::lock_guard<std::mutex> lk(mSessionsMutex);
+
+    Session* existing = findSession(session);
+    if (existing != nullptr)
+        return existing;
+
+    if (!isValidSessionName(session)) {
+        std::cerr << "[LlmStreamService] Invalid session name '" << session << "'" << std::endl;
+        return nullptr;
+    }
+
+    size_t count = mSessionCount.load(std::memory_order_relaxed);
+    if (count >= MAX_SESSIONS) {
+        std::cerr << "[LlmStreamService] Too many sessions, '" << session << "' is not read" << std::endl;
+        return nullptr;
+    }
+
+    Session* created = new Session();
+    created->name = session;
+    created->shmPath = getQueuePath(*created);
+    created->dispatchFn = [this, created]() { dispatchPhonemes(*created); };
+
+    mSessions[count] = std::unique_ptr<Session>(created);
+    mSessionCount.store(count + 1, std::memory_order_release);
+    return created;
+}
+
+std::string LlmStreamService::getQueuePath(const Session& session) const
+{
+    return session.name.empty() ? mShmPath : mShmPath + "." + session.name;
+}
+
+bool LlmStreamService::openSession(const std::string& session)
+{
+    Session* s = getSession(session);
+    if (s == nullptr)
+        return false;
+
+    s->enabled = true;
+    wakeReader();
+    return true;
+}
+
+void LlmStreamService::closeSession(const std::string& session)
+{
+    Session* s = findSession(session);
+    if (s == nullptr || !s->enabled.exchange(false))
+        return;
+
+    // The reader thread releases the mapping
+    wakeReader();
+}
+
+bool LlmStreamService::attach(Session& session)
+{
+    std::string fullPath = "/dev/shm" + session.shmPath;
+
+    // Open shared memory
+    int fd = open(fullPath.c_str(), O_RDWR);
+    if (fd < 0) {
+        session.queueInitializing = false;
+        if (!session.attachErrorLogged)
+            std::cout << "[LlmStreamService] Waiting for phoneme queue at " << fullPath << " (" << strerror(errno) << ")" << std::endl;
+
+        session.attachErrorLogged = true;
+        return false;
+    }
+
+    // Get size of shared memory. The producer may not have sized it yet : try again later.
+    struct stat sb;
+    if (fstat(fd, &sb) == -1 || (size_t)sb.st_size < sizeof(std::uint32_t)) {
+        close(fd);
+        session.queueInitializing = true;
+        return false;
+    }
+
+    // Map shared memory
+    size_t size = (size_t)sb.st_size;
+    void* mem = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mem == MAP_FAILED) {
+        std::cerr << "[LlmStreamService] Failed to map shared memory: " << strerror(errno) << std::endl;
+        close(fd);
+        return false;
+    }
+
+    std::lock_guard<std::mutex> lk(mQueueMutex);
+
+    session.shmFd = fd;
+    session.shmSize = size;
+    session.shmInode = sb.st_ino;
+    session.sharedMem = mem;
+
+    std::string voice;
+
+    // Negotiate the layout : v2 producers write a magic value where v1 has its write index
+    if (*static_cast<const std::uint32_t*>(session.sharedMem) == PHONEME_QUEUE_MAGIC)
+    {
+        auto* header = static_cast<PhonemeQueueHeaderV2*>(session.sharedMem);
+        bool valid = header->version >= 2 && header->header_size >= sizeof(PhonemeQueueHeaderV2) && header->capacity > 0 &&
+            session.shmSize >= header->header_size + (size_t)header->capacity * sizeof(PhonemeData);
+
+        if (valid)
+        {
+            session.queueVersion = header->version >= 3 ? 3 : 2;
+            session.capacity = header->capacity;
+            session.phonemes = reinterpret_cast<PhonemeData*>(static_cast<char*>(session.sharedMem) + header->header_size);
+            session.writeIndex = &header->write_index;
+            session.readIndex = &header->read_index;
+            session.generation = header->generation.load(std::memory_order_acquire);
+            voice = std::string(header->voice, strnlen(header->voice, sizeof(header->voice)));
+            header->high_water.store(0, std::memory_order_relaxed);
+            header->consumer_version.store(3, std::memory_order_release);
+        }
+    }
+    else if (session.shmSize >= sizeof(PhonemeSharedQueue))
+    {
+        auto* queue = static_cast<PhonemeSharedQueue*>(session.sharedMem);
+        session.queueVersion = 1;
+        session.capacity = PhonemeQueueHeader::MAX_PHONEMES;
+        session.phonemes = queue->phonemes;
+        session.writeIndex = &queue->header.write_index;
+        session.readIndex = &queue->header.read_index;
+        session.generation = 0;
+    }
+
+    // Either a producer which is still initializing the segment, or one which has shut down and not removed it yet
+    if (session.queueVersion == 0 || isProducerShutdown(session)) {
+        session.queueInitializing = (session.queueVersion == 0);
+        detachLocked(session);
+        return false;
+    }
+
+    // Read initial read_index from shared memory
+    session.consumerReadIndex = session.readIndex->load(std::memory_order_relaxed) % session.capacity;
+    session.nextSequence = 0;
+    session.overrunLogged = false;
+    session.highWater = false;
+    session.attachErrorLogged = false;
+    session.queueInitializing = false;
+    session.queueFileChanged = false;
+
+    {
+        std::lock_guard<std::mutex> voiceLock(session.voiceMutex);
+        if (voice != session.voice)
+        {
+            session.voice = voice;
+            session.voiceSerial++;
+        }
     }
-    
-    if (mShmFd >= 0) {
-        close(mShmFd);
-        mShmFd = -1;
+
+    if (session.queueVersion >= 2)
+        session.audioClockHeader.store(static_cast<const PhonemeQueueHeaderV2*>(session.sharedMem));
+
+    std::cout << "[LlmStreamService] Connected to phoneme queue at " << fullPath << " (v" << session.queueVersion << (voice.empty() ? "" : ", voice " + voice) << ")" << std::endl;
+    return true;
+}
+
+std::string LlmStreamService::getVoice(const std::string& session) const
+{
+    const Session* s = findSession(session);
+    if (s == nullptr)
+        return std::string();
+
+    std::lock_guard<std::mutex> lock(s->voiceMutex);
+    return s->voice;
+}
+
+std::uint32_t LlmStreamService::getVoiceSerial(const std::string& session) const
+{
+    const Session* s = findSession(session);
+    return s == nullptr ? 0 : s->voiceSerial.load(std::memory_order_acquire);
+}
+
+bool LlmStreamService::getAudioClock(std::uint64_t& positionUs, const std::string& session) const
+{
+    const Session* s = findSession(session);
+    if (s == nullptr)
+        return false;
+
+    bool valid = false;
+
+    s->audioClockReaders.fetch_add(1);
+
+    const PhonemeQueueHeaderV2* header = s->audioClockHeader.load();
+    if (header != nullptr)
+    {
+        std::uint32_t rate = header->audio_sample_rate.load(std::memory_order_relaxed);
+        if (rate != 0)
+        {
+            std::uint64_t samples = header->audio_samples_played.load(std::memory_order_relaxed);
+            positionUs = (samples / rate) * 1000000 + (samples % rate) * 1000000 / rate;
+            valid = true;
+        }
     }
+
+    s->audioClockReaders.fetch_sub(1);
+    return valid;
 }
 
-std::uint64_t LlmStreamService::subscribe(Callback cb)
+void LlmStreamService::detach(Session& session)
+{
+    std::lock_guard<std::mutex> lk(mQueueMutex);
+    detachLocked(session);
+}
+
+void LlmStreamService::detachLocked(Session& session)
+{
+    // Readers load the header after announcing themselves : once the count is 0, none can still use it
+    if (session.audioClockHeader.exchange(nullptr) != nullptr)
+        while (session.audioClockReaders.load() != 0)
+            std::this_thread::yield();
+
+    if (session.sharedMem && session.sharedMem != MAP_FAILED)
+        munmap(session.sharedMem, session.shmSize);
+
+    session.sharedMem = nullptr;
+    session.shmSize = 0;
+
+    if (session.shmFd >= 0) {
+        close(session.shmFd);
+        session.shmFd = -1;
+    }
+
+    session.queueVersion = 0;
+    session.capacity = 0;
+    session.phonemes = nullptr;
+    session.writeIndex = nullptr;
+    session.readIndex = nullptr;
+}
+
+void LlmStreamService::readQueueEvents()
+{
+    if (mInotifyFd < 0)
+        return;
+
+    size_t count = mSessionCount.load(std::memory_order_acquire);
+
+    alignas(struct inotify_event) char buffer[4096];
+    ssize_t len;
+    while ((len = read(mInotifyFd, buffer, sizeof(buffer))) > 0)
+    {
+        for (char* ptr = buffer; ptr < buffer + len; )
+        {
+            auto* event = reinterpret_cast<struct inotify_event*>(ptr);
+            if (event->len > 0)
+            {
+                for (size_t i = 0; i < count; i++)
+                {
+                    const std::string& path = mSessions[i]->shmPath;
+                    if (strcmp(path.c_str() + path.find_first_not_of('/'), event->name) == 0)
+                        mSessions[i]->queueFileChanged = true;
+                }
+            }
+
+            ptr += sizeof(struct inotify_event) + event->len;
+        }
+    }
+}
+
+bool LlmStreamService::producerRestarted(Session& session)
+{
+    // A producer reinitializing the segment in place bumps the generation
+    if (session.queueVersion >= 2 && static_cast<PhonemeQueueHeaderV2*>(session.sharedMem)->generation.load(std::memory_order_acquire) != session.generation)
+        return true;
+
+    // A producer recreating the segment leaves us alone with the unlinked one
+    if (session.queueFileChanged)
+    {
+        session.queueFileChanged = false;
+
+        struct stat sb;
+        std::string fullPath = "/dev/shm" + session.shmPath;
+        if (stat(fullPath.c_str(), &sb) != 0 || sb.st_ino != session.shmInode)
+            return true;
+    }
+
+    return false;
+}
+
+void LlmStreamService::waitForQueue(int timeoutMs)
+{
+    struct pollfd fds[2];
+    int count = 0;
+
+    if (mWakeFd >= 0)
+        fds[count++] = { mWakeFd, POLLIN, 0 };
+
+    if (mInotifyFd >= 0)
+        fds[count++] = { mInotifyFd, POLLIN, 0 };
+
+    poll(fds, count, timeoutMs);
+
+    std::uint64_t value;
+    if (mWakeFd >= 0)
+        while (read(mWakeFd, &value, sizeof(value)) > 0) {}
+}
+
+std::uint64_t LlmStreamService::subscribe(const std::string& session, Callback cb)
+{
+    if (!openSession(session))
+        return 0;
+
+    return addSubscriber(SubRec{ 0, findSession(session), std::move(cb), nullptr });
+}
+
+std::uint64_t LlmStreamService::subscribeTranscript(const std::string& session, TranscriptCallback cb)
+{
+    if (!openSession(session))
+        return 0;
+
+    return addSubscriber(SubRec{ 0, findSession(session), nullptr, std::move(cb) });
+}
+
+std::uint64_t LlmStreamService::addSubscriber(SubRec rec)
 {
     std::lock_guard<std::mutex> lk(mSubsMutex);
-    std::uint64_t id = mNextId++;
-    mSubscribers.push_back(SubRec{ id, std::move(cb) });
-    return id;
+    rec.id = mNextId++;
+
+    const SubList* current = mSubscribers.load(std::memory_order_acquire);
+    SubList* subs = current ? new SubList(*current) : new SubList();
+    subs->push_back(std::move(rec));
+    publishSubscribers(subs);
+    return subs->back().id;
 }
 
 void LlmStreamService::unsubscribe(std::uint64_t id)
 {
     std::lock_guard<std::mutex> lk(mSubsMutex);
-    auto it = std::remove_if(mSubscribers.begin(), mSubscribers.end(), [id](const SubRec& r){ return r.id == id; });
-    mSubscribers.erase(it, mSubscribers.end());
+
+    const SubList* current = mSubscribers.load(std::memory_order_acquire);
+    if (current == nullptr)
+        return;
+
+    SubList* subs = new SubList();
+    subs->reserve(current->size());
+    for (auto& r : *current)
+        if (r.id != id)
+            subs->push_back(r);
+
+    publishSubscribers(subs);
 }
 
-void LlmStreamService::phonemeReaderThread()
+void LlmStreamService::publishSubscribers(SubList* subs)
+{
+    // mSubsMutex is held
+    const SubList* previous = mSubscribers.exchange(subs, std::memory_order_acq_rel);
+
+    // The reader thread only queues the phonemes of the sessions somebody listens to
+    size_t count = mSessionCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++)
+    {
+        const Session* session = mSessions[i].get();
+        mSessions[i]->subscriberCount = std::count_if(subs->cbegin(), subs->cend(), [session](const SubRec& r) { return r.session == session && r.cb; });
+    }
+
+    if (previous != nullptr)
+    {
+        mRetiredSubscribers.push_back(previous);
+        mHasRetiredSubscribers = true;
+    }
+}
+
+void LlmStreamService::releaseRetiredSubscribers()
+{
+    if (!mHasRetiredSubscribers.load())
+        return;
+
+    std::lock_guard<std::mutex> lk(mSubsMutex);
+
+    for (auto subs : mRetiredSubscribers)
+        delete subs;
+
+    mRetiredSubscribers.clear();
+    mHasRetiredSubscribers = false;
+}
+
+void LlmStreamService::dispatchPhonemes(Session& session)
+{
+    // Reset first : anything pushed from now on posts a new dispatch
+    session.dispatchPending = false;
+
+    LipSyncStats::get().record(LipSyncStats::POST_TO_DISPATCH, session.postedUs.load(std::memory_order_relaxed), VisemeScheduler::nowUs());
+
+    size_t popped = session.ring.pop(mUiQueued.data(), mUiQueued.size());
+    std::uint32_t epoch = session.overrunEpoch.load(std::memory_order_acquire);
+
+    size_t count = 0;
+    for (size_t i = 0; i < popped; i++)
+        if (mUiQueued[i].epoch == epoch)
+            mUiBatch[count++] = mUiQueued[i].data;
+
+    if (count < popped)
+    {
+        LipSyncStats::get().count(LipSyncStats::SKIPPED_PHONEMES, popped - count);
+        mDroppedPhonemes += (std::uint32_t)(popped - count);
+    }
+
+    // The reader clears the high-water flag once the backlog is gone
+    if (session.highWater.load(std::memory_order_relaxed))
+        wakeReader();
+
+    deliver(&session, mUiBatch.data(), count);
+}
+
+void LlmStreamService::deliverPhonemes(const PhonemeData* phonemes, size_t count)
+{
+    deliver(findSession(std::string()), phonemes, count);
+}
+
+void LlmStreamService::deliver(const Session* session, const PhonemeData* phonemes, size_t count)
+{
+    // No dispatch is running anymore, lists replaced during the previous ones can go
+    releaseRetiredSubscribers();
+
+    if (count == 0 || session == nullptr)
+        return;
+
+    const SubList* subs = mSubscribers.load(std::memory_order_acquire);
+    if (subs == nullptr)
+        return;
+
+    for (auto& r : *subs)
+        if (r.session == session && r.cb)
+            r.cb(phonemes, count);
+}
+
+void LlmStreamService::deliverTranscript(const std::string& text)
+{
+    releaseRetiredSubscribers();
+
+    const Session* session = findSession(std::string());
+    const SubList* subs = mSubscribers.load(std::memory_order_acquire);
+    if (subs == nullptr || session == nullptr)
+        return;
+
+    for (auto& r : *subs)
+        if (r.session == session && r.transcriptCb)
+            r.transcriptCb(text);
+}
+
+bool LlmStreamService::hasPendingPhonemes(const Session& session) const
+{
+    // The v3 backlog waits for the UI thread to make room, which wakes the reader (see dispatchPhonemes)
+    if (session.queueVersion >= 3 && session.ring.size() >= PHONEME_RING_SIZE)
+        return isProducerShutdown(session);
+
+    return session.writeIndex->load(std::memory_order_acquire) % session.capacity != session.consumerReadIndex || isProducerShutdown(session);
+}
+
+void LlmStreamService::waitForPhonemes(Session& session, int timeoutMs)
+{
+    if (session.queueVersion >= 2)
+    {
+        auto* header = static_cast<PhonemeQueueHeaderV2*>(session.sharedMem);
+
+        std::uint32_t seen = header->doorbell.load(std::memory_order_acquire);
+        if (hasPendingPhonemes(session))
+            return;
+
+        header->consumer_waiting.store(1);
+
+        // FUTEX_WAIT returns immediately if the doorbell rang since 'seen' was read
+        if (mRunning.load() && !hasPendingPhonemes(session))
+            futexWait(&header->doorbell, seen, timeoutMs);
+
+        header->consumer_waiting.store(0, std::memory_order_relaxed);
+        return;
+    }
+
+    auto* queue = static_cast<PhonemeSharedQueue*>(session.sharedMem);
+
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    ts.tv_nsec += timeoutMs * 1000000L;
+    ts.tv_sec += ts.tv_nsec / 1000000000L;
+    ts.tv_nsec %= 1000000000L;
+
+    if (sem_timedwait(&queue->header.sem, &ts) != 0)
+        return;
+
+    // The producer posts once per phoneme : swallow the posts of the phonemes drained by this wake-up
+    while (sem_trywait(&queue->header.sem) == 0) {}
+}
+
+void LlmStreamService::waitForAnyPhonemes(Session** sessions, size_t count, int timeoutMs)
+{
+    bool futexes = mFutexWaitvSupported;
+    for (size_t i = 0; i < count; i++)
+        if (sessions[i]->queueVersion < 2)
+            futexes = false;
+
+    // Semaphores can not be waited on together : poll the queues
+    if (!futexes)
+    {
+        for (size_t i = 0; i < count; i++)
+            if (hasPendingPhonemes(*sessions[i]))
+                return;
+
+        waitForQueue(std::min(timeoutMs, MULTIPLEX_POLL_MS));
+        return;
+    }
+
+    // Sleep on the doorbells of all the queues, and on mWakeWord for wakeReader()
+    FutexWaitv waiters[MAX_SESSIONS + 1];
+    waiters[0] = futexWaiter(&mWakeWord, mWakeWord.load(std::memory_order_acquire));
+
+    for (size_t i = 0; i < count; i++)
+    {
+        auto* header = static_cast<PhonemeQueueHeaderV2*>(sessions[i]->sharedMem);
+        waiters[i + 1] = futexWaiter(&header->doorbell, header->doorbell.load(std::memory_order_acquire));
+        header->consumer_waiting.store(1);
+    }
+
+    // futex_waitv returns immediately if any doorbell rang since it was read
+    bool idle = mRunning.load();
+    for (size_t i = 0; i < count && idle; i++)
+        idle = !hasPendingPhonemes(*sessions[i]);
+
+    if (idle && !futexWaitv(waiters, (unsigned int)count + 1, timeoutMs))
+    {
+        std::cout << "[LlmStreamService] futex_waitv is not supported, polling the phoneme queues" << std::endl;
+        mFutexWaitvSupported = false;
+    }
+
+    for (size_t i = 0; i < count; i++)
+        static_cast<PhonemeQueueHeaderV2*>(sessions[i]->sharedMem)->consumer_waiting.store(0, std::memory_order_relaxed);
+}
+
+void LlmStreamService::wakeReader()
+{
+    if (mWakeFd >= 0)
+    {
+        std::uint64_t value = 1;
+        if (write(mWakeFd, &value, sizeof(value)) < 0) {}
+    }
+
+    mWakeWord.fetch_add(1, std::memory_order_release);
+    futexWake(&mWakeWord);
+
+    std::lock_guard<std::mutex> lk(mQueueMutex);
+
+    size_t count = mSessionCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++)
+    {
+        Session& session = *mSessions[i];
+        if (session.sharedMem == nullptr)
+            continue;
+
+        if (session.queueVersion >= 2)
+        {
+            auto* header = static_cast<PhonemeQueueHeaderV2*>(session.sharedMem);
+            header->doorbell.fetch_add(1, std::memory_order_release);
+            futexWake(&header->doorbell);
+        }
+        else if (session.queueVersion == 1)
+            sem_post(&static_cast<PhonemeSharedQueue*>(session.sharedMem)->header.sem);
+    }
+}
+
+bool LlmStreamService::isProducerShutdown(const Session& session) const
+{
+    if (session.queueVersion >= 2)
+        return static_cast<const PhonemeQueueHeaderV2*>(session.sharedMem)->shutdown_flag.load(std::memory_order_relaxed) != 0;
+
+    return static_cast<const PhonemeSharedQueue*>(session.sharedMem)->header.shutdown_flag.load(std::memory_order_relaxed);
+}
+
+void LlmStreamService::drain(Session& session)
+{
+    std::uint32_t write_index = session.writeIndex->load(std::memory_order_acquire) % session.capacity;
+    if (write_index == session.consumerReadIndex)
+    {
+        updateHighWater(session);
+        return;
+    }
+
+    // Drain everything available, then wake the UI thread once for the whole batch
+    bool pushed = false;
+    std::uint64_t dequeueUs = VisemeScheduler::nowUs();
+
+    while (session.consumerReadIndex != write_index)
+    {
+        // v3 producers overwrite what is not read : leave the backlog in the queue, an overrun then drops the oldest
+        // phonemes rather than the UI hand-off dropping the newest ones
+        if (session.queueVersion >= 3 && session.ring.size() >= PHONEME_RING_SIZE && session.subscriberCount.load(std::memory_order_relaxed) != 0)
+        {
+            if (isSlotOverwritten(session))
+                skipToLatest(session);
+
+            break;
+        }
+
+        PhonemeData data;
+        if (!readSlot(session, data))
+        {
+            skipToLatest(session);
+            break;
+        }
+
+        session.consumerReadIndex = (session.consumerReadIndex + 1) % session.capacity;
+
+        if (data.duration_seconds <= 0 || data.duration_seconds > 10.0f) {
+            std::cerr << "[LlmStreamService] Skipping phoneme " << data.phoneme_id
+                      << " with invalid duration " << data.duration_seconds << "s" << std::endl;
+            continue;
+        }
+
+        if (session.subscriberCount.load(std::memory_order_relaxed) == 0)
+            continue;
+
+        LipSyncStats::get().record(LipSyncStats::PRODUCER_TO_DEQUEUE, data.timestamp_us, dequeueUs);
+
+        if (session.ring.push(QueuedPhoneme{ data, session.overrunEpoch.load(std::memory_order_relaxed) }))
+            pushed = true;
+        else
+        {
+            LipSyncStats::get().count(LipSyncStats::DROPPED_PHONEMES);
+            if (mDroppedPhonemes++ == 0)
+                std::cerr << "[LlmStreamService] UI is not keeping up, dropping phonemes" << std::endl;
+        }
+    }
+
+    session.readIndex->store(session.consumerReadIndex, std::memory_order_release);
+    updateHighWater(session);
+
+    if (pushed && mUiPoster && !session.dispatchPending.exchange(true))
+    {
+        std::uint64_t postUs = VisemeScheduler::nowUs();
+        LipSyncStats::get().record(LipSyncStats::DEQUEUE_TO_POST, dequeueUs, postUs);
+
+        session.postedUs.store(postUs, std::memory_order_relaxed);
+        mUiPoster(session.dispatchFn);
+    }
+}
+
+bool LlmStreamService::readSlot(Session& session, PhonemeData& data)
+{
+    const PhonemeData& slot = session.phonemes[session.consumerReadIndex];
+
+    if (session.queueVersion < 3)
+    {
+        data = slot;
+        return true;
+    }
+
+    // The copy is only valid if the producer did not start rewriting the slot while it was made
+    std::uint32_t sequence = __atomic_load_n(&slot.sequence, __ATOMIC_ACQUIRE);
+    data = slot;
+    std::atomic_thread_fence(std::memory_order_acquire);
+
+    if (sequence == 0 || __atomic_load_n(&slot.sequence, __ATOMIC_RELAXED) != sequence)
+        return false;
+
+    // Any other number than the next one means the slot was written again since
+    if (session.nextSequence != 0 && sequence != session.nextSequence)
+        return false;
+
+    session.nextSequence = sequence + 1 != 0 ? sequence + 1 : 1;
+    return true;
+}
+
+bool LlmStreamService::isSlotOverwritten(const Session& session) const
 {
-    if (!mSharedMem) return;
+    if (session.queueVersion < 3)
+        return false;
 
-    auto* queue = static_cast<PhonemeSharedQueue*>(mSharedMem);
-    constexpr size_t MAX_PHONEMES = PhonemeQueueHeader::MAX_PHONEMES;
+    std::uint32_t sequence = __atomic_load_n(&session.phonemes[session.consumerReadIndex].sequence, __ATOMIC_ACQUIRE);
+    return sequence == 0 || (session.nextSequence != 0 && sequence != session.nextSequence);
+}
 
+void LlmStreamService::skipToLatest(Session& session)
+{
+    // What is left is older than what the producer writes now : go on from its write index
+    std::uint32_t latest = session.writeIndex->load(std::memory_order_acquire) % session.capacity;
+
+    // The sequence numbers tell how many phonemes were written since the last one read. Without them, at least
+    // the unread slots are lost, a whole queue if the producer lapped exactly.
+    std::uint32_t lastWritten = __atomic_load_n(&session.phonemes[(latest + session.capacity - 1) % session.capacity].sequence, __ATOMIC_ACQUIRE);
+    std::uint32_t skipped = (latest + session.capacity - session.consumerReadIndex) % session.capacity;
+
+    if (session.nextSequence != 0 && lastWritten != 0 && lastWritten - session.nextSequence < 0x80000000u)
+        skipped = lastWritten - session.nextSequence + 1;
+    else if (skipped == 0)
+        skipped = session.capacity;
+
+    // Keep checking the sequence numbers from there, the reader may still be behind
+    session.consumerReadIndex = latest;
+    session.nextSequence = lastWritten != 0 && lastWritten + 1 != 0 ? lastWritten + 1 : lastWritten != 0 ? 1 : 0;
+
+    // What the UI thread was not given yet is just as stale
+    session.overrunEpoch.fetch_add(1, std::memory_order_release);
+
+    static_cast<PhonemeQueueHeaderV2*>(session.sharedMem)->overruns.fetch_add(1, std::memory_order_relaxed);
+    LipSyncStats::get().count(LipSyncStats::QUEUE_OVERRUNS);
+    LipSyncStats::get().count(LipSyncStats::SKIPPED_PHONEMES, skipped);
+    mDroppedPhonemes += skipped;
+
+    if (!session.overrunLogged)
+        std::cerr << "[LlmStreamService] Producer overran " << session.shmPath << ", skipping " << skipped << " stale phonemes" << std::endl;
+
+    session.overrunLogged = true;
+}
+
+void LlmStreamService::updateHighWater(Session& session)
+{
+    if (session.queueVersion < 2)
+        return;
+
+    std::uint32_t capacity = session.capacity;
+    std::uint32_t backlog = (session.writeIndex->load(std::memory_order_relaxed) % capacity + capacity - session.consumerReadIndex) % capacity;
+    size_t uiBacklog = session.ring.size();
+
+    bool high = session.highWater.load(std::memory_order_relaxed);
+
+    if (!high && ((std::uint64_t)backlog * 4 > (std::uint64_t)capacity * PHONEME_QUEUE_HIGH_WATER_QUARTERS || uiBacklog * 4 > PHONEME_RING_SIZE * PHONEME_QUEUE_HIGH_WATER_QUARTERS))
+    {
+        high = true;
+        LipSyncStats::get().count(LipSyncStats::HIGH_WATER_MARKS);
+    }
+    else if (high && (std::uint64_t)backlog * 4 < (std::uint64_t)capacity * PHONEME_QUEUE_LOW_WATER_QUARTERS && uiBacklog * 4 < PHONEME_RING_SIZE * PHONEME_QUEUE_LOW_WATER_QUARTERS)
+        high = false;
+    else
+        return;
+
+    session.highWater = high;
+    static_cast<PhonemeQueueHeaderV2*>(session.sharedMem)->high_water.store(high ? 1 : 0, std::memory_order_release);
+}
+
+void LlmStreamService::phonemeReaderThread()
+{
     std::cout << "[LlmStreamService] Phoneme reader thread started" << std::endl;
 
+    Session* attached[MAX_SESSIONS];
+
     while (mRunning.load())
     {
         try {
-            sem_wait(&queue->header.sem);
+            readQueueEvents();
 
-            std::uint32_t write_index = queue->header.write_index.load(std::memory_order_acquire);
-            bool shutdown_flag = queue->header.shutdown_flag.load(std::memory_order_relaxed);
+            size_t attachedCount = 0;
+            bool missingQueues = false;
+            int timeoutMs = READER_WAIT_TIMEOUT_MS * 2;
+            std::uint64_t now = VisemeScheduler::nowUs();
 
-            if (shutdown_flag) {
-                std::cout << "[LlmStreamService] Shutdown signal received" << std::endl;
-                break;
-            }
-
-            while (mConsumerReadIndex != write_index)
+            size_t count = mSessionCount.load(std::memory_order_acquire);
+            for (size_t i = 0; i < count && mRunning.load(); i++)
             {
-                const PhonemeData& data = queue->phonemes[mConsumerReadIndex];
+                Session& session = *mSessions[i];
+
+                if (!session.enabled.load())
+                {
+                    if (session.sharedMem != nullptr)
+                        detach(session);
 
-                if (data.duration_seconds <= 0 || data.duration_seconds > 10.0f) {
-                    std::cerr << "[LlmStreamService] Skipping phoneme " << data.phoneme_id
-                              << " with invalid duration " << data.duration_seconds << "s" << std::endl;
-                    mConsumerReadIndex = (mConsumerReadIndex + 1) % MAX_PHONEMES;
-                    queue->header.read_index.store(mConsumerReadIndex, std::memory_order_release);
                     continue;
                 }
 
-                if (mUiPoster)
+                if (session.sharedMem == nullptr)
                 {
-                    std::vector<SubRec> subs;
+                    // Probe on the events of this queue file, and periodically in any case as inotify may be unavailable.
+                    // Segments being initialized get no event : retry them soon.
+                    if ((session.queueFileChanged || now >= session.nextProbeUs) && !attach(session))
                     {
-                        std::lock_guard<std::mutex> lk(mSubsMutex);
-                        subs = mSubscribers;
+                        session.queueFileChanged = false;
+                        session.nextProbeUs = now + (session.queueInitializing ? QUEUE_INIT_RETRY_MS : READER_WAIT_TIMEOUT_MS * 2) * 1000ULL;
                     }
-                    if (!subs.empty())
+
+                    if (session.sharedMem == nullptr)
                     {
-                        PhonemeData dataCopy = data;
-                        mUiPoster([subs, dataCopy]() {
-                            for (auto& r : subs)
-                                r.cb(dataCopy);
-                        });
+                        missingQueues = true;
+                        timeoutMs = std::min(timeoutMs, (int)((std::max(session.nextProbeUs, now) - now) / 1000));
+                        continue;
                     }
                 }
 
-                mConsumerReadIndex = (mConsumerReadIndex + 1) % MAX_PHONEMES;
-                queue->header.read_index.store(mConsumerReadIndex, std::memory_order_release);
+                // Producer gone or restarted : release this mapping and wait for the next one
+                if (isProducerShutdown(session)) {
+                    std::cout << "[LlmStreamService] Shutdown signal received on " << session.shmPath << ", waiting for the producer to come back" << std::endl;
+                    detach(session);
+                    session.nextProbeUs = now + READER_WAIT_TIMEOUT_MS * 2 * 1000ULL;
+                    missingQueues = true;
+                    continue;
+                }
+
+                if (producerRestarted(session)) {
+                    std::cout << "[LlmStreamService] Producer of " << session.shmPath << " restarted, reconnecting" << std::endl;
+                    detach(session);
+                    session.nextProbeUs = 0;
+                    missingQueues = true;
+                    timeoutMs = 0;
+                    continue;
+                }
+
+                drain(session);
+                attached[attachedCount++] = &session;
             }
 
+            if (!mRunning.load())
+                break;
+
+            // A single queue waits on its own doorbell or semaphore, several ones are multiplexed
+            if (attachedCount == 0)
+                waitForQueue(timeoutMs);
+            else if (attachedCount == 1 && !missingQueues)
+                waitForPhonemes(*attached[0], READER_WAIT_TIMEOUT_MS);
+            else
+                waitForAnyPhonemes(attached, attachedCount, std::min(timeoutMs, missingQueues ? QUEUE_PROBE_MS : READER_WAIT_TIMEOUT_MS));
+
         } catch (const std::exception& e) {
             std::cerr << "[LlmStreamService] Error: " << e.what() << std::endl;
             // std::this_thread::sleep_for(std::chrono::milliseconds(100));
         }
     }
 
+    size_t count = mSessionCount.load(std::memory_order_acquire);
+    for (size_t i = 0; i < count; i++)
+        detach(*mSessions[i]);
+
     std::cout << "[LlmStreamService] Phoneme reader thread stopped" << std::endl;
 }
 
-bool LlmStreamService::sendControlCommand(const std::string& command)
+bool LlmStreamService::sendControlCommand(const std::string& command, TtsControlChannel::AckCallback onAck)
 {
-    // Connect to TTS control socket
-    int sock_fd = socket(AF_UNIX, SOCK_STREAM, 0);
-    if (sock_fd < 0) {
-        std::cerr << "[LlmStreamService] Failed to create control socket: " << strerror(errno) << std::endl;
-        return false;
-    }
-    
-    struct sockaddr_un addr;
-    memset(&addr, 0, sizeof(addr));
-    addr.sun_family = AF_UNIX;
-    strncpy(addr.sun_path, mControlSocketPath.c_str(), sizeof(addr.sun_path) - 1);
-    
-    if (connect(sock_fd, (struct sockaddr*)&addr, sizeof(addr)) < 0) {
-        std::cerr << "[LlmStreamService] Failed to connect to control socket at " 
-                  << mControlSocketPath << ": " << strerror(errno) << std::endl;
-        close(sock_fd);
-        return false;
-    }
-    
-    // Send command
-    std::string cmd = command + "\n";
-    ssize_t sent = write(sock_fd, cmd.c_str(), cmd.length());
-    close(sock_fd);
-    
-    if (sent < 0) {
-        std::cerr << "[LlmStreamService] Failed to send command: " << strerror(errno) << std::endl;
-        return false;
-    }
-    
-    std::cout << "[LlmStreamService] Sent control command: " << command << std::endl;
-    return true;
+    return mControlChannel.send(command, onAck);
 }
 
 
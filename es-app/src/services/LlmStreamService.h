@@ -3,13 +3,19 @@
 #include <atomic>
 #include <cstdint>
 #include <functional>
+#include <memory>
 #include <mutex>
 #include <semaphore.h>
+#include <sys/types.h>
 #include <string>
 #include <thread>
 #include <vector>
 
+#include "utils/SpscRing.h"
+#include "TtsControlChannel.h"
+
 // Shared memory queue header (layout must match TTS producer)
+// v1 : the producer posts 'sem' once per phoneme.
 struct PhonemeQueueHeader {
   std::atomic<std::uint32_t> write_index{0};
   std::atomic<std::uint32_t> read_index{0};
@@ -18,6 +24,49 @@ struct PhonemeQueueHeader {
   static constexpr size_t MAX_PHONEMES = 1024;
 };
 
+// v2 : starts with a magic value, which a v1 write_index (always < MAX_PHONEMES) can never be.
+// Phonemes start at 'header_size' and there are 'capacity' slots.
+// The producer writes the slots, stores write_index, then increments 'doorbell' and calls FUTEX_WAKE on it
+// when 'consumer_waiting' is set. ES sleeps with FUTEX_WAIT on 'doorbell' and drains everything between
+// read_index and write_index on each wake-up. ES stores the highest layout version it supports in
+// 'consumer_version' when it attaches. The producer changes 'generation' each time it reinitializes the queue.
+// 'voice' is the NUL terminated name of the voice model, which selects the phoneme -> viseme map.
+// 'audio_samples_played' is the number of samples the TTS audio callback has played since the producer started
+// (never reset), at 'audio_sample_rate'. A sample rate of 0 means the producer does not publish its audio clock.
+// ES sets 'high_water' while its backlog is above 3/4 of the queue (or of its own hand-off to the UI thread) and
+// clears it below 1/4 : producers should slow down meanwhile. 'overruns' counts the overruns ES detected.
+// v3 : same header, but the producer may overwrite slots which were not read yet instead of waiting. Each slot has
+// a sequence number : the producer stores 0 in 'sequence', writes the phoneme, stores the number of phonemes
+// written so far (never 0) in 'sequence', then advances write_index. A slot which does not have the next expected
+// sequence number was overwritten : ES then skips everything that is left and goes on with the latest phonemes.
+static constexpr std::uint32_t PHONEME_QUEUE_MAGIC = 0x51484850; // "PHHQ"
+
+struct PhonemeQueueHeaderV2 {
+  std::uint32_t magic;
+  std::uint16_t version;
+  std::uint16_t header_size;
+  std::uint32_t capacity;
+  std::atomic<std::uint32_t> consumer_version;
+  std::atomic<std::uint32_t> write_index;
+  std::atomic<std::uint32_t> read_index;
+  std::atomic<std::uint32_t> shutdown_flag;
+  std::atomic<std::uint32_t> doorbell;
+  std::atomic<std::uint32_t> consumer_waiting;
+  std::atomic<std::uint32_t> generation;
+  char voice[48];
+  std::atomic<std::uint64_t> audio_samples_played;
+  std::atomic<std::uint32_t> audio_sample_rate;
+  std::atomic<std::uint32_t> high_water;
+  std::atomic<std::uint32_t> overruns;
+  std::uint32_t reserved[5];
+};
+
+static_assert(sizeof(PhonemeQueueHeaderV2) == 128, "PhonemeQueueHeaderV2 layout is shared with the TTS producer");
+
+// Backlog thresholds of the 'high_water' flag, in quarters of the queue capacity
+static constexpr std::uint32_t PHONEME_QUEUE_HIGH_WATER_QUARTERS = 3;
+static constexpr std::uint32_t PHONEME_QUEUE_LOW_WATER_QUARTERS = 1;
+
 class LlmStreamService {
 public:
   using UiPoster = std::function<void(const std::function<void()> &)>;
@@ -26,6 +75,7 @@ public:
   struct PhonemeData {
     std::int64_t phoneme_id;
     float duration_seconds;
+    std::uint32_t sequence; // v3 slot sequence number, padding before
     std::uint64_t timestamp_us;
   };
 
@@ -35,41 +85,191 @@ public:
     PhonemeData phonemes[PhonemeQueueHeader::MAX_PHONEMES];
   };
 
-  using Callback = std::function<void(const PhonemeData &)>;
+  // Subscribers are called on the UI thread with every phoneme read since the previous call
+  using Callback = std::function<void(const PhonemeData *phonemes, size_t count)>;
+  // Transcript subscribers are called on the UI thread with each text message (see LlmSocketService)
+  using TranscriptCallback = std::function<void(const std::string &text)>;
+
+  // Each session (AI character, per player assistant...) has its own queue : the default session "" reads
+  // 'shmPath', session "name" reads 'shmPath.name'. A single reader thread serves all the sessions.
+  static constexpr size_t MAX_SESSIONS = 16;
 
   static LlmStreamService &get();
 
+  // Starts the reader thread, which attaches to the queues as soon as they exist and reattaches when a
+  // producer restarts. Never blocks.
   void start(const std::string &shmPath, UiPoster uiPoster);
   void stop();
 
-  // Subscribe to phoneme events; returns subscription id
-  std::uint64_t subscribe(Callback cb);
+  // Starts / stops reading the queue of a session. Session names are made of letters, digits, '-' and '_'.
+  // Subscribing to a session opens it.
+  bool openSession(const std::string &session);
+  void closeSession(const std::string &session);
+
+  // Subscribe to phoneme events; returns subscription id (0 if the session name is invalid)
+  std::uint64_t subscribe(Callback cb) { return subscribe(std::string(), std::move(cb)); }
+  std::uint64_t subscribe(const std::string &session, Callback cb);
+  std::uint64_t subscribeTranscript(TranscriptCallback cb) { return subscribeTranscript(std::string(), std::move(cb)); }
+  std::uint64_t subscribeTranscript(const std::string &session, TranscriptCallback cb);
   void unsubscribe(std::uint64_t id);
 
-  // Send control commands to TTS server
-  bool sendControlCommand(const std::string &command);
+  // UI thread : hands phonemes or text from another source than the shared memory queues to the subscribers
+  // of the default session
+  void deliverPhonemes(const PhonemeData *phonemes, size_t count);
+  void deliverTranscript(const std::string &text);
+
+  // Voice model announced by the producer of a session (empty if unknown). The serial changes with the voice.
+  std::string getVoice(const std::string &session = std::string()) const;
+  std::uint32_t getVoiceSerial(const std::string &session = std::string()) const;
+
+  // Audio playback position of the producer of a session, in microseconds. Lock free, meant to be polled every
+  // frame. Returns false when no producer publishes its audio clock.
+  bool getAudioClock(std::uint64_t &positionUs, const std::string &session = std::string()) const;
+
+  // Phonemes lost because the UI thread did not keep up or a producer overran its queue, all sessions included
+  unsigned int getDroppedPhonemes() const { return mDroppedPhonemes.load(std::memory_order_relaxed); }
+
+  // Queues a control command for the TTS server and returns at once. 'onAck' is called on the UI thread
+  // with the server reply, or with the reason why the command was not acknowledged.
+  bool sendControlCommand(const std::string &command, TtsControlChannel::AckCallback onAck = nullptr);
 
 private:
   LlmStreamService() = default;
   ~LlmStreamService();
 
+  static constexpr size_t PHONEME_RING_SIZE = 1024;
+
+  // Phoneme handed to the UI thread, with the number of overruns of its queue when it was read : the UI thread
+  // drops the ones read before the last overrun, which are older than what the producer writes now
+  struct QueuedPhoneme {
+    PhonemeData data;
+    std::uint32_t epoch;
+  };
+
+  // One phoneme queue. Sessions are created once and never deleted while the process runs : the reader
+  // thread, the UI thread and getAudioClock() use them without locking.
+  struct Session {
+    std::string name;
+    std::atomic<bool> enabled{true};
+
+    // Reader thread state. mQueueMutex guards the mapping against wakeReader().
+    std::string shmPath;
+    void *sharedMem{nullptr};
+    size_t shmSize{0};
+    int shmFd{-1};
+    ino_t shmInode{0};
+    std::uint32_t generation{0};
+    bool attachErrorLogged{false};
+    bool queueInitializing{false};
+    bool queueFileChanged{false};
+    std::uint64_t nextProbeUs{0};
+    std::uint32_t consumerReadIndex{0};
+    // v3 : sequence number of the next slot, 0 when unknown (after attaching or skipping)
+    std::uint32_t nextSequence{0};
+    bool overrunLogged{false};
+    std::atomic<bool> highWater{false};
+
+    // Mapped queue, whatever its layout version
+    int queueVersion{0};
+    std::uint32_t capacity{0};
+    PhonemeData *phonemes{nullptr};
+    std::atomic<std::uint32_t> *writeIndex{nullptr};
+    std::atomic<std::uint32_t> *readIndex{nullptr};
+
+    mutable std::mutex voiceMutex;
+    std::string voice;
+    std::atomic<std::uint32_t> voiceSerial{0};
+
+    // v2 header read by getAudioClock. detachLocked() waits for readers to leave before unmapping.
+    std::atomic<const PhonemeQueueHeaderV2 *> audioClockHeader{nullptr};
+    mutable std::atomic<int> audioClockReaders{0};
+
+    // Reader thread -> UI thread hand-off. At most one dispatch is posted at a time.
+    Utils::SpscRing<QueuedPhoneme, PHONEME_RING_SIZE> ring;
+    std::atomic<std::uint32_t> overrunEpoch{0};
+    std::function<void()> dispatchFn;
+    std::atomic<bool> dispatchPending{false};
+    std::atomic<std::uint64_t> postedUs{0};
+    std::atomic<size_t> subscriberCount{0};
+  };
+
+  static bool isValidSessionName(const std::string &session);
+  // Lock free lookup, nullptr if the session was never opened
+  Session *findSession(const std::string &session) const;
+  Session *getSession(const std::string &session);
+  std::string getQueuePath(const Session &session) const;
+
   void phonemeReaderThread();
 
+  // Reader thread : maps the queue / releases the mapping
+  bool attach(Session &session);
+  void detach(Session &session);
+  void detachLocked(Session &session);
+  // Reader thread : reads the queue file events of every session
+  void readQueueEvents();
+  bool producerRestarted(Session &session);
+  // Reader thread : moves the new phonemes of an attached queue to its ring and wakes the UI thread
+  void drain(Session &session);
+  // Reader thread : copies the slot at the read index, false if the producer overwrote it (v3)
+  bool readSlot(Session &session, PhonemeData &data);
+  bool isSlotOverwritten(const Session &session) const;
+  void skipToLatest(Session &session);
+  void updateHighWater(Session &session);
+
+  // Reader thread : blocks until a queue may have appeared, a producer signals new phonemes, stop() or a timeout
+  void waitForQueue(int timeoutMs);
+  void waitForPhonemes(Session &session, int timeoutMs);
+  void waitForAnyPhonemes(Session **sessions, size_t count, int timeoutMs);
+  bool hasPendingPhonemes(const Session &session) const;
+  // Wakes the reader thread from any of the waits
+  void wakeReader();
+  bool isProducerShutdown(const Session &session) const;
+
+  // UI thread : hands the phonemes waiting in the ring of a session to its subscribers
+  void dispatchPhonemes(Session &session);
+  void deliver(const Session *session, const PhonemeData *phonemes, size_t count);
+
   std::thread mThread;
   std::atomic<bool> mRunning{false};
   std::string mShmPath{"/tts_phoneme_queue"};
   std::string mControlSocketPath{"/tmp/tts_face_control.sock"};
+  TtsControlChannel mControlChannel;
   UiPoster mUiPoster;
 
-  void *mSharedMem{nullptr};
-  int mShmFd{-1};
-  std::uint32_t mConsumerReadIndex{0};
+  std::mutex mQueueMutex;
+  int mInotifyFd{-1};
+  int mWakeFd{-1};
+  // Futex word waited on with the doorbells of all the queues, rung by wakeReader()
+  std::atomic<std::uint32_t> mWakeWord{0};
+  bool mFutexWaitvSupported{true};
+
+  // Sessions are appended under mSessionsMutex and published by mSessionCount
+  std::mutex mSessionsMutex;
+  std::unique_ptr<Session> mSessions[MAX_SESSIONS];
+  std::atomic<size_t> mSessionCount{0};
+
+  // UI side of the hand-off, shared by the sessions as dispatches all run on the UI thread
+  std::vector<QueuedPhoneme> mUiQueued;
+  std::vector<PhonemeData> mUiBatch;
+  std::atomic<std::uint32_t> mDroppedPhonemes{0};
 
   struct SubRec {
     std::uint64_t id;
+    const Session *session;
     Callback cb;
+    TranscriptCallback transcriptCb;
   };
+  using SubList = std::vector<SubRec>;
+
+  // Copy-on-write subscriber list : writers publish a new list under mSubsMutex, dispatchPhonemes reads
+  // it without locking. Replaced lists are deleted by the next dispatch, once the previous one is over.
+  std::uint64_t addSubscriber(SubRec rec);
+  void publishSubscribers(SubList *subs);
+  void releaseRetiredSubscribers();
+
   std::mutex mSubsMutex;
-  std::vector<SubRec> mSubscribers;
+  std::atomic<const SubList *> mSubscribers{nullptr};
+  std::vector<const SubList *> mRetiredSubscribers;
+  std::atomic<bool> mHasRetiredSubscribers{false};
   std::atomic<std::uint64_t> mNextId{1};
 };
@@ -0,0 +1,483 @@
+#include "PhonemeReplay.h"
+#include "LipSyncStats.h"
+#include "VisemeScheduler.h"
+
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <climits>
+#include <cstdlib>
+#include <cstring>
+#include <cerrno>
+#include <chrono>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+
+// Simulated UI frame, for the headless runs
+static const std::uint64_t FRAME_US = 16667;
+
+// Functions posted by LlmStreamService, run by the thread standing for the UI thread
+class PostedFunctions
+{
+public:
+    void post(const std::function<void()>& fn)
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+        mFunctions.push_back(fn);
+    }
+
+    // Returns the number of functions run
+    size_t run()
+    {
+        std::vector<std::function<void()>> functions;
+
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            functions.swap(mFunctions);
+        }
+
+        for (auto& fn : functions)
+            fn();
+
+        return functions.size();
+    }
+
+private:
+    std::mutex mMutex;
+    std::vector<std::function<void()>> mFunctions;
+};
+
+bool PhonemeReplay::loadTrace(const std::string& path, std::vector<PhonemeData>& trace)
+{
+    std::ifstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "[PhonemeReplay] Unable to open trace " << path << std::endl;
+        return false;
+    }
+
+    trace.clear();
+
+    std::string line;
+    int lineNumber = 0;
+    while (std::getline(file, line))
+    {
+        lineNumber++;
+
+        size_t start = line.find_first_not_of(" \t\r");
+        if (start == std::string::npos || line[start] == '#')
+            continue;
+
+        std::istringstream ss(line);
+
+        long long id = 0;
+        float duration = 0;
+        unsigned long long timestamp = 0;
+        if (!(ss >> id >> duration)) {
+            std::cerr << "[PhonemeReplay] " << path << ":" << lineNumber << ": invalid line" << std::endl;
+            return false;
+        }
+
+        ss >> timestamp;
+
+        PhonemeData data;
+        data.phoneme_id = id;
+        data.duration_seconds = duration;
+        data.sequence = 0;
+        data.timestamp_us = timestamp;
+        trace.push_back(data);
+    }
+
+    return !trace.empty();
+}
+
+int PhonemeReplay::record(const std::string& path, const std::string& shmPath, int seconds)
+{
+    std::ofstream file(path);
+    if (!file.is_open()) {
+        std::cerr << "[PhonemeReplay] Unable to create trace " << path << std::endl;
+        return 1;
+    }
+
+    file << "# phoneme_id duration_seconds timestamp_us" << std::endl;
+
+    PostedFunctions ui;
+    size_t count = 0;
+
+    auto& service = LlmStreamService::get();
+    service.start(shmPath, [&ui](const std::function<void()>& fn) { ui.post(fn); });
+
+    std::uint64_t subId = service.subscribe([&file, &count](const PhonemeData* phonemes, size_t n)
+    {
+        for (size_t i = 0; i < n; i++)
+            file << phonemes[i].phoneme_id << " " << std::setprecision(6) << phonemes[i].duration_seconds << " " << phonemes[i].timestamp_us << "\n";
+
+        file.flush();
+        count += n;
+    });
+
+    std::cout << "[PhonemeReplay] Recording " << shmPath << " to " << path << " for " << seconds << "s" << std::endl;
+
+    auto end = std::chrono::steady_clock::now() + std::chrono::seconds(seconds);
+    while (std::chrono::steady_clock::now() < end)
+    {
+        ui.run();
+        std::this_thread::sleep_for(std::chrono::microseconds(FRAME_US));
+    }
+
+    ui.run();
+    service.unsubscribe(subId);
+    service.stop();
+
+    std::cout << "[PhonemeReplay] " << count << " phonemes recorded" << std::endl;
+    return 0;
+}
+
+int PhonemeReplay::replay(const std::string& path, const std::string& shmPath, float speed, int version)
+{
+    std::vector<PhonemeData> trace;
+    if (!loadTrace(path, trace))
+        return 1;
+
+    Producer producer;
+    if (!producer.create(shmPath, version))
+        return 1;
+
+    std::cout << "[PhonemeReplay] Playing " << trace.size() << " phonemes on " << shmPath << " (v" << version << ", x" << speed << ")" << std::endl;
+
+    producer.waitForConsumer(5000);
+    producer.play(trace, speed);
+    producer.destroy();
+
+    std::cout << "[PhonemeReplay] " << producer.getWritten() << " phonemes written, " << producer.getOverruns() << " overruns" << std::endl;
+    return 0;
+}
+
+int PhonemeReplay::benchmark(const std::string& path, float speed, int version)
+{
+    std::vector<PhonemeData> trace;
+    if (!loadTrace(path, trace))
+        return 1;
+
+    // Private queue : never disturbs a TTS server running on the same machine
+    std::string shmPath = "/es_phoneme_benchmark_" + std::to_string(getpid());
+
+    Producer producer;
+    if (!producer.create(shmPath, version))
+        return 1;
+
+    LipSyncStats::get().reset();
+
+    PostedFunctions ui;
+    VisemeScheduler scheduler;
+    size_t received = 0;
+    size_t visemeChanges = 0;
+
+    auto& service = LlmStreamService::get();
+    service.start(shmPath, [&ui](const std::function<void()>& fn) { ui.post(fn); });
+
+    // The benchmark does not need a face : phoneme ids are used as visemes
+    std::uint64_t subId = service.subscribe([&scheduler, &received](const PhonemeData* phonemes, size_t count)
+    {
+        std::uint64_t now = VisemeScheduler::nowUs();
+        for (size_t i = 0; i < count; i++)
+            scheduler.push(phonemes[i].timestamp_us, phonemes[i].duration_seconds, (int)phonemes[i].phoneme_id, now);
+
+        received += count;
+    });
+
+    if (!producer.waitForConsumer(5000))
+        std::cerr << "[PhonemeReplay] Consumer did not attach, measuring anyway" << std::endl;
+
+    std::atomic<bool> done(false);
+    auto startTime = std::chrono::steady_clock::now();
+
+    std::thread producerThread([&producer, &trace, speed, &done]()
+    {
+        producer.play(trace, speed);
+        done = true;
+    });
+
+    // UI loop : run the posted dispatches and advance the timeline once per frame, until everything was displayed
+    std::uint64_t idleSince = 0;
+    std::uint64_t nextFrame = VisemeScheduler::nowUs();
+
+    for (;;)
+    {
+        nextFrame += FRAME_US;
+        std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::microseconds(nextFrame)));
+
+        std::uint64_t now = VisemeScheduler::nowUs();
+        bool busy = ui.run() > 0;
+
+        if (scheduler.update(now))
+        {
+            visemeChanges++;
+            LipSyncStats::get().record(LipSyncStats::SCHEDULE_TO_RENDER, scheduler.getCurrentStart(), now);
+            LipSyncStats::get().record(LipSyncStats::PRODUCER_TO_RENDER, scheduler.getCurrentProducerTimestamp(), now);
+        }
+
+        if (!done.load() || busy || scheduler.isActive())
+        {
+            idleSince = 0;
+            continue;
+        }
+
+        if (idleSince == 0)
+            idleSince = now;
+
+        // Leave the reader a little time in case phonemes are still in flight, more if some are missing
+        bool complete = received + service.getDroppedPhonemes() >= producer.getWritten();
+        if (now - idleSince > (complete ? 200000 : 2000000))
+            break;
+    }
+
+    double elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+
+    producerThread.join();
+    service.unsubscribe(subId);
+    service.stop();
+    producer.destroy();
+
+    unsigned int dropped = service.getDroppedPhonemes();
+
+    std::cout << std::fixed << std::setprecision(1)
+        << "Phoneme benchmark : " << path << " (v" << version << ", x" << speed << ")\n"
+        << "  phonemes  : " << trace.size() << " in trace, " << producer.getWritten() << " written, " << received << " received\n"
+        << "  overruns  : " << producer.getOverruns() << " in the shared queue, " << dropped << " dropped by ES\n"
+        << "  throughput: " << (elapsed > 0 ? received / elapsed : 0) << " phonemes/s over " << elapsed << "s\n"
+        << "  visemes   : " << visemeChanges << " changes\n"
+        << LipSyncStats::get().toOverlayText() << std::endl;
+
+    return received == trace.size() ? 0 : 1;
+}
+
+PhonemeReplay::Producer::~Producer()
+{
+    destroy();
+}
+
+bool PhonemeReplay::Producer::create(const std::string& shmPath, int version)
+{
+    destroy();
+
+    mShmPath = shmPath;
+    mVersion = version >= 3 ? 3 : version >= 2 ? 2 : 1;
+    mOverruns = 0;
+    mWritten = 0;
+    mSequence = 0;
+
+    // Start from a fresh segment, like a restarted TTS server
+    shm_unlink(mShmPath.c_str());
+
+    int fd = shm_open(mShmPath.c_str(), O_CREAT | O_RDWR, 0666);
+    if (fd < 0) {
+        std::cerr << "[PhonemeReplay] Failed to create " << mShmPath << ": " << strerror(errno) << std::endl;
+        return false;
+    }
+
+    mCapacity = (std::uint32_t)PhonemeQueueHeader::MAX_PHONEMES;
+    mShmSize = mVersion >= 2 ? sizeof(PhonemeQueueHeaderV2) + mCapacity * sizeof(PhonemeData) : sizeof(LlmStreamService::PhonemeSharedQueue);
+
+    if (ftruncate(fd, (off_t)mShmSize) != 0) {
+        std::cerr << "[PhonemeReplay] Failed to size " << mShmPath << ": " << strerror(errno) << std::endl;
+        close(fd);
+        shm_unlink(mShmPath.c_str());
+        return false;
+    }
+
+    mSharedMem = mmap(nullptr, mShmSize, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    close(fd);
+
+    if (mSharedMem == MAP_FAILED) {
+        std::cerr << "[PhonemeReplay] Failed to map " << mShmPath << ": " << strerror(errno) << std::endl;
+        mSharedMem = nullptr;
+        shm_unlink(mShmPath.c_str());
+        return false;
+    }
+
+    memset(mSharedMem, 0, mShmSize);
+
+    if (mVersion >= 2)
+    {
+        auto* header = static_cast<PhonemeQueueHeaderV2*>(mSharedMem);
+        header->version = (std::uint16_t)mVersion;
+        header->header_size = sizeof(PhonemeQueueHeaderV2);
+        header->capacity = mCapacity;
+        header->generation.store((std::uint32_t)rand(), std::memory_order_relaxed);
+
+        mPhonemes = reinterpret_cast<PhonemeData*>(static_cast<char*>(mSharedMem) + header->header_size);
+        mWriteIndex = &header->write_index;
+        mReadIndex = &header->read_index;
+
+        // Published last : consumers ignore the segment until the magic is there
+        std::atomic_thread_fence(std::memory_order_release);
+        header->magic = PHONEME_QUEUE_MAGIC;
+    }
+    else
+    {
+        auto* queue = static_cast<LlmStreamService::PhonemeSharedQueue*>(mSharedMem);
+        sem_init(&queue->header.sem, 1, 0);
+
+        mPhonemes = queue->phonemes;
+        mWriteIndex = &queue->header.write_index;
+        mReadIndex = &queue->header.read_index;
+    }
+
+    return true;
+}
+
+void PhonemeReplay::Producer::destroy()
+{
+    if (mSharedMem == nullptr)
+        return;
+
+    // Tell the consumer, like the TTS server does when it exits
+    if (mVersion >= 2)
+    {
+        auto* header = static_cast<PhonemeQueueHeaderV2*>(mSharedMem);
+        header->shutdown_flag.store(1, std::memory_order_release);
+        header->doorbell.fetch_add(1, std::memory_order_release);
+        syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&header->doorbell), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+    else
+    {
+        auto* queue = static_cast<LlmStreamService::PhonemeSharedQueue*>(mSharedMem);
+        queue->header.shutdown_flag.store(true, std::memory_order_release);
+        sem_post(&queue->header.sem);
+    }
+
+    munmap(mSharedMem, mShmSize);
+    shm_unlink(mShmPath.c_str());
+
+    mSharedMem = nullptr;
+    mPhonemes = nullptr;
+    mWriteIndex = nullptr;
+    mReadIndex = nullptr;
+}
+
+bool PhonemeReplay::Producer::waitForConsumer(int timeoutMs)
+{
+    if (mSharedMem == nullptr)
+        return false;
+
+    if (mVersion < 2)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(std::min(timeoutMs, 200)));
+        return true;
+    }
+
+    auto* header = static_cast<PhonemeQueueHeaderV2*>(mSharedMem);
+    auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(timeoutMs);
+
+    while (header->consumer_version.load(std::memory_order_acquire) == 0)
+    {
+        if (std::chrono::steady_clock::now() >= end)
+            return false;
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+
+    return true;
+}
+
+bool PhonemeReplay::Producer::push(const PhonemeData& data)
+{
+    std::uint32_t writeIndex = mWriteIndex->load(std::memory_order_relaxed) % mCapacity;
+    std::uint32_t next = (writeIndex + 1) % mCapacity;
+
+    bool full = next == mReadIndex->load(std::memory_order_acquire) % mCapacity;
+
+    if (mVersion >= 3)
+    {
+        // v3 never waits for the consumer : unread slots are overwritten, the consumer notices it from their
+        // sequence numbers and skips to the latest phonemes
+        if (full)
+            mOverruns++;
+
+        PhonemeData& slot = mPhonemes[writeIndex];
+        __atomic_store_n(&slot.sequence, 0, __ATOMIC_RELAXED);
+        std::atomic_thread_fence(std::memory_order_release);
+
+        slot.phoneme_id = data.phoneme_id;
+        slot.duration_seconds = data.duration_seconds;
+        slot.timestamp_us = data.timestamp_us;
+
+        mSequence = mSequence + 1 != 0 ? mSequence + 1 : 1;
+        __atomic_store_n(&slot.sequence, mSequence, __ATOMIC_RELEASE);
+    }
+    else if (full) {
+        mOverruns++;
+        return false;
+    }
+    else
+        mPhonemes[writeIndex] = data;
+
+    mWriteIndex->store(next, std::memory_order_release);
+    mWritten++;
+
+    if (mVersion >= 2)
+    {
+        auto* header = static_cast<PhonemeQueueHeaderV2*>(mSharedMem);
+        header->doorbell.fetch_add(1, std::memory_order_release);
+
+        if (header->consumer_waiting.load(std::memory_order_acquire) != 0)
+            syscall(SYS_futex, reinterpret_cast<std::uint32_t*>(&header->doorbell), FUTEX_WAKE, INT_MAX, nullptr, nullptr, 0);
+    }
+    else
+        sem_post(&static_cast<LlmStreamService::PhonemeSharedQueue*>(mSharedMem)->header.sem);
+
+    return true;
+}
+
+void PhonemeReplay::Producer::play(const std::vector<PhonemeData>& trace, float speed, const std::atomic<bool>* cancel)
+{
+    if (mSharedMem == nullptr || trace.empty())
+        return;
+
+    if (speed <= 0)
+        speed = 1.0f;
+
+    std::uint64_t base = VisemeScheduler::nowUs();
+
+    // Offsets follow the trace timestamps, or chain the durations where they are missing
+    std::uint64_t offset = 0;
+    std::uint64_t stampBase = 0;
+    std::uint64_t firstStamp = 0;
+
+    for (size_t i = 0; i < trace.size(); i++)
+    {
+        if (cancel != nullptr && cancel->load())
+            break;
+
+        const PhonemeData& src = trace[i];
+
+        if (src.timestamp_us != 0 && (firstStamp == 0 || src.timestamp_us >= firstStamp))
+        {
+            if (firstStamp == 0) {
+                firstStamp = src.timestamp_us;
+                stampBase = offset;
+            }
+
+            offset = stampBase + (std::uint64_t)((src.timestamp_us - firstStamp) / speed);
+        }
+        else if (i > 0)
+            offset += (std::uint64_t)(trace[i - 1].duration_seconds * 1000000.0 / speed);
+
+        std::uint64_t release = base + offset;
+        std::this_thread::sleep_until(std::chrono::steady_clock::time_point(std::chrono::microseconds(release)));
+
+        PhonemeData data = src;
+        data.duration_seconds = src.duration_seconds / speed;
+        data.timestamp_us = release;
+        push(data);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+#ifndef ES_APP_SERVICES_PHONEME_REPLAY_H
+#define ES_APP_SERVICES_PHONEME_REPLAY_H
+
+#include "LlmStreamService.h"
+#include <atomic>
+#include <string>
+#include <vector>
+
+// Recorded phoneme streams, to work on the face without a live TTS server.
+// Trace files are text, one phoneme per line : "<phoneme_id> <duration_seconds> <timestamp_us>".
+// Empty lines and lines starting with '#' are ignored. A timestamp of 0 means "right after the previous phoneme".
+class PhonemeReplay
+{
+public:
+    using PhonemeData = LlmStreamService::PhonemeData;
+
+    static bool loadTrace(const std::string& path, std::vector<PhonemeData>& trace);
+
+    // --phoneme-record : writes what the TTS server sends on 'shmPath' to a trace file, for 'seconds'
+    static int record(const std::string& path, const std::string& shmPath, int seconds);
+
+    // --phoneme-replay : stand-in TTS server, plays a trace on 'shmPath' for a running ES
+    static int replay(const std::string& path, const std::string& shmPath, float speed, int version);
+
+    // --phoneme-benchmark : headless run of the producer, LlmStreamService and the viseme scheduler.
+    // Prints throughput, overruns and latencies. Returns non zero if phonemes were lost.
+    static int benchmark(const std::string& path, float speed, int version);
+
+    // Writes phonemes in the shared memory queue layout (v1 PhonemeSharedQueue, v2 or v3), on the trace timing
+    class Producer
+    {
+    public:
+        Producer() = default;
+        ~Producer();
+
+        bool create(const std::string& shmPath, int version);
+        void destroy();
+
+        // Waits until a consumer attached (v2) or for a short while (v1, which has no way to tell)
+        bool waitForConsumer(int timeoutMs);
+
+        // Blocks until the whole trace is written. Phonemes are stamped with the steady clock at their release time.
+        // 'speed' > 1 plays faster, durations are scaled accordingly.
+        void play(const std::vector<PhonemeData>& trace, float speed, const std::atomic<bool>* cancel = nullptr);
+
+        // Phonemes dropped because the queue was full (v1, v2), or unread phonemes overwritten (v3)
+        unsigned int getOverruns() const { return mOverruns; }
+        unsigned int getWritten() const { return mWritten; }
+
+    private:
+        bool push(const PhonemeData& data);
+
+        std::string mShmPath;
+        void* mSharedMem = nullptr;
+        size_t mShmSize = 0;
+        int mVersion = 0;
+
+        std::uint32_t mCapacity = 0;
+        PhonemeData* mPhonemes = nullptr;
+        std::atomic<std::uint32_t>* mWriteIndex = nullptr;
+        std::atomic<std::uint32_t>* mReadIndex = nullptr;
+
+        unsigned int mOverruns = 0;
+        unsigned int mWritten = 0;
+        std::uint32_t mSequence = 0;
+    };
+};
+
+#endif // ES_APP_SERVICES_PHONEME_REPLAY_H
@@ -0,0 +1,338 @@
+#include "TtsControlChannel.h"
+
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <iostream>
+
+// Upper bound of a poll, so that a stop request is never missed for long
+static const int CHANNEL_POLL_TIMEOUT_MS = 1000;
+
+TtsControlChannel::~TtsControlChannel()
+{
+    stop();
+}
+
+void TtsControlChannel::start(const std::string& socketPath, UiPoster uiPoster)
+{
+    stop();
+
+    mSocketPath = socketPath;
+    mUiPoster = uiPoster;
+    mReconnectDelayMs = MIN_RECONNECT_DELAY_MS;
+    mNextConnect = Clock::now();
+    mConnectErrorLogged = false;
+
+    mWakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (mWakeFd < 0) {
+        std::cerr << "[TtsControlChannel] Failed to create wake-up fd: " << strerror(errno) << std::endl;
+        return;
+    }
+
+    mRunning = true;
+    mThread = std::thread(&TtsControlChannel::run, this);
+}
+
+void TtsControlChannel::stop()
+{
+    if (mRunning.exchange(false))
+    {
+        std::uint64_t value = 1;
+        if (write(mWakeFd, &value, sizeof(value)) < 0) {}
+
+        if (mThread.joinable())
+            mThread.join();
+    }
+
+    if (mSocket >= 0) {
+        close(mSocket);
+        mSocket = -1;
+    }
+
+    if (mWakeFd >= 0) {
+        close(mWakeFd);
+        mWakeFd = -1;
+    }
+
+    // Nobody is left to hear about these
+    mConnecting = false;
+    mConnected = false;
+    mOutput.clear();
+    mInput.clear();
+    mAwaitingAck.clear();
+
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+    mQueue.clear();
+}
+
+bool TtsControlChannel::send(const std::string& command, AckCallback onAck)
+{
+    if (!mRunning.load())
+        return false;
+
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        if (mQueue.size() >= MAX_QUEUED_COMMANDS) {
+            std::cerr << "[TtsControlChannel] Queue full, dropping command: " << command << std::endl;
+            return false;
+        }
+
+        Command cmd;
+        cmd.line = command + "\n";
+        cmd.onAck = onAck;
+        cmd.deadline = Clock::now() + std::chrono::milliseconds(COMMAND_EXPIRY_MS);
+        mQueue.push_back(std::move(cmd));
+    }
+
+    std::uint64_t value = 1;
+    if (write(mWakeFd, &value, sizeof(value)) < 0) {}
+
+    return true;
+}
+
+void TtsControlChannel::run()
+{
+    while (mRunning.load())
+    {
+        Clock::time_point now = Clock::now();
+
+        if (mSocket < 0 && now >= mNextConnect)
+            connectSocket();
+
+        takeQueuedCommands(now);
+        expireAcks(now);
+
+        if (mSocket >= 0 && !mConnecting && !mOutput.empty() && !flushOutput())
+            disconnect("write failed");
+
+        struct pollfd fds[2];
+        int count = 0;
+
+        fds[count++] = { mWakeFd, POLLIN, 0 };
+
+        if (mSocket >= 0)
+            fds[count++] = { mSocket, (short)(POLLIN | (mConnecting || !mOutput.empty() ? POLLOUT : 0)), 0 };
+
+        if (poll(fds, count, nextTimeoutMs(now)) < 0 && errno != EINTR)
+            break;
+
+        std::uint64_t value;
+        while (read(mWakeFd, &value, sizeof(value)) > 0) {}
+
+        if (count < 2 || fds[1].revents == 0)
+            continue;
+
+        if (mConnecting)
+        {
+            int error = 0;
+            socklen_t len = sizeof(error);
+            if (getsockopt(mSocket, SOL_SOCKET, SO_ERROR, &error, &len) < 0 || error != 0) {
+                disconnect(strerror(error != 0 ? error : errno));
+                continue;
+            }
+
+            onConnected();
+        }
+
+        if ((fds[1].revents & POLLIN) && !readReplies())
+            disconnect("connection closed by server");
+        else if ((fds[1].revents & (POLLERR | POLLHUP)) && !(fds[1].revents & POLLIN))
+            disconnect("connection lost");
+    }
+}
+
+bool TtsControlChannel::connectSocket()
+{
+    mSocket = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    if (mSocket < 0) {
+        disconnect(strerror(errno));
+        return false;
+    }
+
+    struct sockaddr_un addr;
+    memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    strncpy(addr.sun_path, mSocketPath.c_str(), sizeof(addr.sun_path) - 1);
+
+    if (connect(mSocket, (struct sockaddr*)&addr, sizeof(addr)) == 0) {
+        onConnected();
+        return true;
+    }
+
+    int error = errno;
+    if (error == EINPROGRESS) {
+        mConnecting = true;
+        return true;
+    }
+
+    if (!mConnectErrorLogged)
+        std::cerr << "[TtsControlChannel] Failed to connect to control socket at " << mSocketPath << ": " << strerror(error) << std::endl;
+
+    mConnectErrorLogged = true;
+    disconnect(strerror(error));
+    return false;
+}
+
+void TtsControlChannel::onConnected()
+{
+    mConnecting = false;
+    mConnected = true;
+    mReconnectDelayMs = MIN_RECONNECT_DELAY_MS;
+    mConnectErrorLogged = false;
+
+    std::cout << "[TtsControlChannel] Connected to " << mSocketPath << std::endl;
+}
+
+void TtsControlChannel::disconnect(const std::string& reason)
+{
+    bool wasConnected = mConnected.exchange(false);
+
+    if (mSocket >= 0) {
+        close(mSocket);
+        mSocket = -1;
+    }
+
+    if (wasConnected)
+        std::cout << "[TtsControlChannel] Disconnected from " << mSocketPath << ": " << reason << std::endl;
+
+    mConnecting = false;
+    mOutput.clear();
+    mInput.clear();
+
+    for (auto& command : mAwaitingAck)
+        acknowledge(command, false, reason);
+
+    mAwaitingAck.clear();
+
+    // Failed attempts back off. A server closing an established connection is reconnected after the minimum
+    // delay : older servers close it after each command.
+    mNextConnect = Clock::now() + std::chrono::milliseconds(mReconnectDelayMs);
+
+    if (!wasConnected)
+        mReconnectDelayMs = std::min(mReconnectDelayMs * 2, MAX_RECONNECT_DELAY_MS);
+}
+
+void TtsControlChannel::takeQueuedCommands(Clock::time_point now)
+{
+    std::lock_guard<std::mutex> lock(mQueueMutex);
+
+    while (!mQueue.empty())
+    {
+        Command& command = mQueue.front();
+
+        if (mConnected.load() && !mConnecting)
+        {
+            mOutput += command.line;
+            command.deadline = now + std::chrono::milliseconds(ACK_TIMEOUT_MS);
+            mAwaitingAck.push_back(std::move(command));
+        }
+        else if (now >= command.deadline)
+        {
+            std::cerr << "[TtsControlChannel] Dropping command, TTS server not reachable: " << command.line;
+            acknowledge(command, false, "not connected");
+        }
+        else
+            break;
+
+        mQueue.pop_front();
+    }
+}
+
+bool TtsControlChannel::flushOutput()
+{
+    while (!mOutput.empty())
+    {
+        ssize_t sent = ::send(mSocket, mOutput.data(), mOutput.size(), MSG_NOSIGNAL);
+        if (sent < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+        mOutput.erase(0, (size_t)sent);
+    }
+
+    return true;
+}
+
+bool TtsControlChannel::readReplies()
+{
+    char buffer[512];
+
+    for (;;)
+    {
+        ssize_t len = recv(mSocket, buffer, sizeof(buffer), 0);
+        if (len == 0)
+            return false;
+
+        if (len < 0)
+            return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+
+        mInput.append(buffer, (size_t)len);
+
+        size_t pos;
+        while ((pos = mInput.find('\n')) != std::string::npos)
+        {
+            std::string reply = mInput.substr(0, pos);
+            mInput.erase(0, pos + 1);
+
+            if (!reply.empty() && reply.back() == '\r')
+                reply.pop_back();
+
+            if (mAwaitingAck.empty()) {
+                std::cout << "[TtsControlChannel] Unexpected reply: " << reply << std::endl;
+                continue;
+            }
+
+            bool ok = reply == "ok" || reply.compare(0, 3, "ok ") == 0;
+            acknowledge(mAwaitingAck.front(), ok, reply);
+            mAwaitingAck.pop_front();
+        }
+    }
+}
+
+void TtsControlChannel::expireAcks(Clock::time_point now)
+{
+    // Replies are matched by order : once one is missing the following ones can't be trusted, restart the connection
+    if (!mAwaitingAck.empty() && now >= mAwaitingAck.front().deadline)
+        disconnect("no reply from server");
+}
+
+void TtsControlChannel::acknowledge(Command& command, bool ok, const std::string& reply)
+{
+    if (!command.onAck)
+        return;
+
+    AckCallback onAck = std::move(command.onAck);
+    command.onAck = nullptr;
+
+    if (mUiPoster)
+        mUiPoster([onAck, ok, reply]() { onAck(ok, reply); });
+    else
+        onAck(ok, reply);
+}
+
+int TtsControlChannel::nextTimeoutMs(Clock::time_point now) const
+{
+    Clock::time_point next = now + std::chrono::milliseconds(CHANNEL_POLL_TIMEOUT_MS);
+
+    if (mSocket < 0)
+        next = std::min(next, mNextConnect);
+
+    if (!mAwaitingAck.empty())
+        next = std::min(next, mAwaitingAck.front().deadline);
+
+    {
+        std::lock_guard<std::mutex> lock(mQueueMutex);
+        if (!mQueue.empty())
+            next = std::min(next, mQueue.front().deadline);
+    }
+
+    if (next <= now)
+        return 0;
+
+    return (int)std::chrono::duration_cast<std::chrono::milliseconds>(next - now).count() + 1;
+}
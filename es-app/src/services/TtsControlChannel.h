@@ -0,0 +1,94 @@
+#pragma once
+#ifndef ES_APP_SERVICES_TTS_CONTROL_CHANNEL_H
+#define ES_APP_SERVICES_TTS_CONTROL_CHANNEL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Persistent connection to the TTS server control socket, owned by a background thread.
+// Commands are newline terminated lines. Each line sent back by the server acknowledges the oldest command
+// still waiting for one : "ok" (optionally followed by text) means success, anything else is an error.
+// send() only queues the command : the UI never waits on the TTS process. The connection is reopened with
+// an exponential backoff when the server is not there or goes away.
+class TtsControlChannel
+{
+public:
+    using UiPoster = std::function<void(const std::function<void()>&)>;
+
+    // Called on the UI thread. 'reply' is the server line, or the reason why no acknowledgement was received.
+    using AckCallback = std::function<void(bool ok, const std::string& reply)>;
+
+    // Commands which could not be sent within this delay are dropped : face_show/face_hide are state changes,
+    // replaying them long after the fact would be wrong
+    static constexpr int COMMAND_EXPIRY_MS = 2000;
+    static constexpr int ACK_TIMEOUT_MS = 2000;
+    static constexpr int MIN_RECONNECT_DELAY_MS = 100;
+    static constexpr int MAX_RECONNECT_DELAY_MS = 5000;
+    static constexpr size_t MAX_QUEUED_COMMANDS = 32;
+
+    TtsControlChannel() = default;
+    ~TtsControlChannel();
+
+    void start(const std::string& socketPath, UiPoster uiPoster);
+    void stop();
+
+    // Never blocks. Returns false if the command could not be queued.
+    bool send(const std::string& command, AckCallback onAck = nullptr);
+
+    bool isConnected() const { return mConnected.load(std::memory_order_relaxed); }
+
+private:
+    using Clock = std::chrono::steady_clock;
+
+    struct Command
+    {
+        std::string line;
+        AckCallback onAck;
+        Clock::time_point deadline;
+    };
+
+    void run();
+
+    bool connectSocket();
+    void onConnected();
+    void disconnect(const std::string& reason);
+
+    // Moves queued commands to the output buffer, drops expired ones
+    void takeQueuedCommands(Clock::time_point now);
+    bool flushOutput();
+    bool readReplies();
+    void expireAcks(Clock::time_point now);
+
+    void acknowledge(Command& command, bool ok, const std::string& reply);
+    int nextTimeoutMs(Clock::time_point now) const;
+
+    std::thread mThread;
+    std::atomic<bool> mRunning{false};
+    std::atomic<bool> mConnected{false};
+    std::string mSocketPath;
+    UiPoster mUiPoster;
+
+    int mWakeFd{-1};
+
+    // Shared with the UI thread
+    mutable std::mutex mQueueMutex;
+    std::deque<Command> mQueue;
+
+    // Channel thread only
+    int mSocket{-1};
+    bool mConnecting{false};
+    std::string mOutput;
+    std::string mInput;
+    std::deque<Command> mAwaitingAck;
+    int mReconnectDelayMs{MIN_RECONNECT_DELAY_MS};
+    Clock::time_point mNextConnect;
+    bool mConnectErrorLogged{false};
+};
+
+#endif // ES_APP_SERVICES_TTS_CONTROL_CHANNEL_H
@@ -0,0 +1,123 @@
+#include "VisemeMap.h"
+
+#include "resources/ResourceManager.h"
+#include "utils/FileSystemUtil.h"
+#include "utils/StringUtil.h"
+#include "Log.h"
+#include <pugixml/src/pugixml.hpp>
+#include <algorithm>
+#include <cctype>
+#include <map>
+#include <mutex>
+
+// Phoneme ids above this are certainly a broken file, not a phoneme inventory
+static const int MAX_PHONEME_ID = 4095;
+
+static int findViseme(const std::vector<std::string>& visemeNames, const std::string& name)
+{
+    auto it = std::find(visemeNames.cbegin(), visemeNames.cend(), name);
+    return it == visemeNames.cend() ? -1 : (int)(it - visemeNames.cbegin());
+}
+
+// Voice names come from the TTS server : only accept plain file names
+static bool isValidVoiceName(const std::string& voice)
+{
+    if (voice.empty() || voice.find("..") != std::string::npos)
+        return false;
+
+    for (auto c : voice)
+        if (!isalnum((unsigned char)c) && c != '_' && c != '-' && c != '.')
+            return false;
+
+    return true;
+}
+
+std::shared_ptr<const VisemeMap> VisemeMap::get(const std::string& directory, const std::string& voice, const std::vector<std::string>& visemeNames)
+{
+    static std::mutex cacheLock;
+    static std::map<std::string, std::shared_ptr<const VisemeMap>> cache;
+
+    std::string path = directory + "/default.xml";
+    if (isValidVoiceName(voice) && ResourceManager::getInstance()->fileExists(directory + "/" + voice + ".xml"))
+        path = directory + "/" + voice + ".xml";
+
+    std::unique_lock<std::mutex> lock(cacheLock);
+
+    auto it = cache.find(path);
+    if (it != cache.cend())
+        return it->second;
+
+    auto map = std::make_shared<VisemeMap>();
+    map->load(path, visemeNames);
+
+    // Cache failures too : the file is not read again for every utterance
+    cache[path] = map;
+    return map;
+}
+
+bool VisemeMap::load(const std::string& path, const std::vector<std::string>& visemeNames)
+{
+    mTable.clear();
+    mDefault = HOLD;
+    mRest = 0;
+
+    std::string xmlpath = ResourceManager::getInstance()->getResourcePath(path);
+
+    pugi::xml_document doc;
+    pugi::xml_parse_result result = doc.load_file(WINSTRINGW(xmlpath).c_str());
+    if (!result)
+    {
+        LOG(LogError) << "VisemeMap : Error parsing " << xmlpath << " : " << result.description();
+        return false;
+    }
+
+    pugi::xml_node root = doc.child("visemes");
+    if (!root)
+    {
+        LOG(LogError) << "VisemeMap : " << xmlpath << " has no <visemes> node";
+        return false;
+    }
+
+    int rest = findViseme(visemeNames, root.attribute("rest").as_string());
+    mRest = rest >= 0 ? rest : 0;
+
+    int defaultViseme = findViseme(visemeNames, root.attribute("default").as_string());
+    if (defaultViseme >= 0)
+        mDefault = (unsigned char)defaultViseme;
+
+    for (pugi::xml_node node = root.child("phoneme"); node; node = node.next_sibling("phoneme"))
+    {
+        int id = node.attribute("id").as_int(-1);
+        if (id < 0 || id > MAX_PHONEME_ID)
+        {
+            LOG(LogWarning) << "VisemeMap : " << xmlpath << " : invalid phoneme id " << node.attribute("id").as_string();
+            continue;
+        }
+
+        unsigned char entry;
+
+        if (node.attribute("hold").as_bool())
+            entry = HOLD;
+        else if (node.attribute("closing").as_bool())
+            entry = CLOSING;
+        else
+        {
+            int viseme = findViseme(visemeNames, node.attribute("viseme").as_string());
+            if (viseme < 0 || viseme > VISEME_MASK)
+            {
+                LOG(LogWarning) << "VisemeMap : " << xmlpath << " : unknown viseme " << node.attribute("viseme").as_string() << " for phoneme " << id;
+                continue;
+            }
+
+            entry = (unsigned char)viseme;
+        }
+
+        if ((size_t)id >= mTable.size())
+            mTable.resize((size_t)id + 1, mDefault);
+
+        mTable[(size_t)id] = entry;
+    }
+
+    LOG(LogDebug) << "VisemeMap : " << mTable.size() << " phonemes loaded from " << xmlpath;
+    return true;
+}
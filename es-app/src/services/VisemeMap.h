@@ -0,0 +1,49 @@
+#pragma once
+#ifndef ES_APP_SERVICES_VISEME_MAP_H
+#define ES_APP_SERVICES_VISEME_MAP_H
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Phoneme id -> viseme table of a voice model, loaded from an xml resource and compiled into one byte per phoneme id :
+// the viseme index in the low bits, plus the HOLD / CLOSING flags. See resources/BMO_Face/visemes/default.xml.
+class VisemeMap
+{
+public:
+    static constexpr unsigned char VISEME_MASK = 0x3F;
+    static constexpr unsigned char CLOSING = 0x40; // close the mouth (rest viseme)
+    static constexpr unsigned char HOLD = 0x80;    // keep the current viseme
+
+    // Map of 'voice' in 'directory' (<voice>.xml, or default.xml). Each file is only compiled once.
+    // 'visemeNames' gives the viseme index of each name used in the files.
+    static std::shared_ptr<const VisemeMap> get(const std::string& directory, const std::string& voice, const std::vector<std::string>& visemeNames);
+
+    bool load(const std::string& path, const std::vector<std::string>& visemeNames);
+
+    unsigned char lookup(std::int64_t phonemeId) const
+    {
+        return phonemeId >= 0 && (std::uint64_t)phonemeId < mTable.size() ? mTable[(size_t)phonemeId] : mDefault;
+    }
+
+    // Viseme to display for 'phonemeId' when 'currentViseme' is displayed (-1 if none)
+    int map(std::int64_t phonemeId, int currentViseme) const
+    {
+        unsigned char entry = lookup(phonemeId);
+        if (entry & HOLD)
+            return currentViseme >= 0 ? currentViseme : mRest;
+        if (entry & CLOSING)
+            return mRest;
+        return entry & VISEME_MASK;
+    }
+
+    int getRestViseme() const { return mRest; }
+
+private:
+    std::vector<unsigned char> mTable;
+    unsigned char mDefault = 0;
+    int mRest = 0;
+};
+
+#endif // ES_APP_SERVICES_VISEME_MAP_H
@@ -0,0 +1,189 @@
+#include "VisemeScheduler.h"
+
+#include <algorithm>
+#include <chrono>
+
+std::uint64_t VisemeScheduler::nowUs()
+{
+    return (std::uint64_t) std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+void VisemeScheduler::push(std::uint64_t producerTimestampUs, float durationSeconds, int viseme, std::uint64_t now)
+{
+    std::uint64_t durationUs = durationSeconds > 0 ? (std::uint64_t)(durationSeconds * 1000000.0) : 0;
+    std::uint64_t start;
+
+    if (!isActive() && now >= mTimelineEndUs)
+    {
+        // New utterance : anchor the producer clock on the local clock
+        start = now;
+        mLocalAnchorUs = now;
+        mProducerAnchorUs = producerTimestampUs;
+    }
+    else
+    {
+        start = mTimelineEndUs;
+
+        if (producerTimestampUs != 0 && mProducerAnchorUs != 0 && producerTimestampUs >= mProducerAnchorUs)
+        {
+            std::uint64_t stamped = mLocalAnchorUs + (producerTimestampUs - mProducerAnchorUs);
+            std::int64_t diff = (std::int64_t)stamped - (std::int64_t)start;
+
+            if (diff >= -MAX_CORRECTION_US && diff <= MAX_CORRECTION_US)
+                start = stamped;
+            else
+            {
+                // Stamps are not in the same timebase as the durations (pause, producer restart...) : re-anchor
+                mLocalAnchorUs = start;
+                mProducerAnchorUs = producerTimestampUs;
+            }
+        }
+        else if (producerTimestampUs != 0)
+        {
+            mLocalAnchorUs = start;
+            mProducerAnchorUs = producerTimestampUs;
+        }
+
+        // Never go back before the previous phoneme start
+        if (mHead < mEntries.size() && start < mEntries.back().startUs)
+            start = mEntries.back().startUs;
+    }
+
+    // Compact consumed entries instead of reallocating
+    if (mHead > 0 && mHead == mEntries.size())
+    {
+        mEntries.clear();
+        mHead = 0;
+    }
+    else if (mHead > 64 && mHead * 2 > mEntries.size())
+    {
+        mEntries.erase(mEntries.begin(), mEntries.begin() + mHead);
+        mHead = 0;
+    }
+
+    Entry entry;
+    entry.startUs = start;
+    entry.endUs = start + durationUs;
+    entry.producerUs = producerTimestampUs;
+    entry.viseme = viseme;
+    mEntries.push_back(entry);
+
+    mTimelineEndUs = entry.endUs;
+}
+
+bool VisemeScheduler::update(std::uint64_t now)
+{
+    const Entry* current = nullptr;
+
+    // Skip everything that is already over : a late frame drops phonemes rather than delaying the next ones
+    while (mHead < mEntries.size())
+    {
+        const Entry& entry = mEntries[mHead];
+        if (entry.startUs > now)
+            break;
+
+        current = &entry;
+        if (entry.endUs > now)
+            break;
+
+        mHead++;
+    }
+
+    if (current == nullptr || current->viseme < 0 || current->viseme == mCurrentViseme)
+        return false;
+
+    mPreviousViseme = mCurrentViseme;
+    mCurrentViseme = current->viseme;
+    mCurrentStartUs = current->startUs;
+    mCurrentEndUs = current->endUs;
+    mCurrentProducerUs = current->producerUs;
+    return true;
+}
+
+float VisemeScheduler::getBlend(std::uint64_t now, std::uint64_t fadeUs) const
+{
+    if (mPreviousViseme < 0 || mPreviousViseme == mCurrentViseme || mCurrentStartUs == 0)
+        return 1.0f;
+
+    std::uint64_t fade = std::min(fadeUs, (mCurrentEndUs - mCurrentStartUs) / 2);
+    if (fade == 0 || now >= mCurrentStartUs + fade)
+        return 1.0f;
+
+    if (now <= mCurrentStartUs)
+        return 0.0f;
+
+    return (float)(now - mCurrentStartUs) / (float)fade;
+}
+
+void VisemeScheduler::syncAudioClock(std::uint64_t audioUs, std::uint64_t now)
+{
+    // Only the progress during an utterance matters : start over from the current position otherwise
+    if (!isActive() || mAudioClockLocalUs == 0 || audioUs < mAudioClockUs)
+    {
+        mAudioClockUs = audioUs;
+        mAudioClockLocalUs = now;
+        mAudioProgressUs = now;
+        mAudioLagUs = 0;
+        return;
+    }
+
+    std::int64_t localDelta = (std::int64_t)(now - mAudioClockLocalUs);
+    std::int64_t audioDelta = (std::int64_t)(audioUs - mAudioClockUs);
+
+    if (audioDelta > 0)
+        mAudioProgressUs = now;
+
+    mAudioClockUs = audioUs;
+    mAudioClockLocalUs = now;
+
+    // A clock which does not move at all is not playing this utterance : don't hold the face forever
+    if (now - mAudioProgressUs > AUDIO_STALL_TIMEOUT_US)
+    {
+        mAudioLagUs = 0;
+        return;
+    }
+
+    // Positive when the audio is late on the timeline
+    mAudioLagUs += localDelta - audioDelta;
+
+    if (mAudioLagUs > AUDIO_SYNC_TOLERANCE_US || mAudioLagUs < -AUDIO_SYNC_TOLERANCE_US)
+    {
+        std::int64_t correction = mAudioLagUs / AUDIO_SYNC_GAIN_DIVIDER;
+        shift(correction, now);
+        mAudioLagUs -= correction;
+    }
+}
+
+void VisemeScheduler::shift(std::int64_t us, std::uint64_t now)
+{
+    if (us == 0 || !isActive())
+        return;
+
+    for (size_t i = mHead; i < mEntries.size(); i++)
+    {
+        Entry& entry = mEntries[i];
+
+        if (entry.startUs > now)
+            entry.startUs = (std::uint64_t)std::max<std::int64_t>(0, (std::int64_t)entry.startUs + us);
+
+        entry.endUs = (std::uint64_t)std::max<std::int64_t>((std::int64_t)entry.startUs, (std::int64_t)entry.endUs + us);
+    }
+
+    mTimelineEndUs = mEntries.back().endUs;
+    mLocalAnchorUs = (std::uint64_t)((std::int64_t)mLocalAnchorUs + us);
+
+    if (mCurrentEndUs != 0)
+        mCurrentEndUs = (std::uint64_t)std::max<std::int64_t>((std::int64_t)mCurrentStartUs, (std::int64_t)mCurrentEndUs + us);
+}
+
+void VisemeScheduler::clear()
+{
+    mEntries.clear();
+    mHead = 0;
+    mTimelineEndUs = 0;
+    mLocalAnchorUs = 0;
+    mProducerAnchorUs = 0;
+    mAudioClockLocalUs = 0;
+    mAudioLagUs = 0;
+}
@@ -0,0 +1,92 @@
+#pragma once
+#ifndef ES_APP_SERVICES_VISEME_SCHEDULER_H
+#define ES_APP_SERVICES_VISEME_SCHEDULER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Converts the phoneme stream into a timeline of absolute presentation times (steady clock, microseconds)
+// and picks the viseme to display when polled from the UI thread. Each phoneme start is derived from the
+// producer timestamp (or from the end of the previous phoneme when the stamp is missing or inconsistent),
+// so scheduling error never accumulates over an utterance.
+class VisemeScheduler
+{
+public:
+    // Maximum correction applied when the producer timestamp disagrees with the duration chain
+    static constexpr std::int64_t MAX_CORRECTION_US = 80000;
+
+    struct Entry
+    {
+        std::uint64_t startUs;
+        std::uint64_t endUs;
+        std::uint64_t producerUs;
+        int viseme;
+    };
+
+    // Audio clock slaving : lag tolerated before correcting (audio callbacks advance the clock by whole buffers),
+    // share of the remaining lag corrected per update, and how long a clock may stall before it is ignored
+    static constexpr std::int64_t AUDIO_SYNC_TOLERANCE_US = 40000;
+    static constexpr std::int64_t AUDIO_SYNC_GAIN_DIVIDER = 4;
+    static constexpr std::uint64_t AUDIO_STALL_TIMEOUT_US = 2000000;
+
+    static std::uint64_t nowUs();
+
+    // producerTimestampUs can be 0 if the producer does not stamp phonemes
+    void push(std::uint64_t producerTimestampUs, float durationSeconds, int viseme, std::uint64_t now);
+
+    // Advances the timeline up to 'now'. Returns true when the current viseme changed.
+    bool update(std::uint64_t now);
+
+    // Slaves the timeline to the producer audio clock (any monotonic position in microseconds), to be called
+    // before update(). While phonemes play, the difference between the audio progress and the local clock
+    // accumulates (buffering, underruns...) and the pending timeline is moved by a share of it on each call.
+    void syncAudioClock(std::uint64_t audioUs, std::uint64_t now);
+
+    // Moves the phonemes which are not over yet. The current one keeps its start.
+    void shift(std::int64_t us, std::uint64_t now);
+
+    void clear();
+
+    // -1 when no viseme is selected
+    int getCurrentViseme() const { return mCurrentViseme; }
+    void setCurrentViseme(int viseme) { mCurrentViseme = viseme; mPreviousViseme = -1; mCurrentStartUs = mCurrentEndUs = mCurrentProducerUs = 0; }
+
+    // Viseme displayed before the current one, -1 when there is nothing to blend from
+    int getPreviousViseme() const { return mPreviousViseme; }
+
+    // Weight of the current viseme against the previous one at 'now' : ramps from 0 to 1 over 'fadeUs' after the
+    // scheduled start, shortened to half the phoneme duration so short phonemes still reach their full shape
+    float getBlend(std::uint64_t now, std::uint64_t fadeUs) const;
+
+    // Scheduled start and producer timestamp of the phoneme which selected the current viseme (0 when unknown)
+    std::uint64_t getCurrentStart() const { return mCurrentStartUs; }
+    std::uint64_t getCurrentProducerTimestamp() const { return mCurrentProducerUs; }
+
+    // True while there are phonemes being displayed or waiting to be displayed
+    bool isActive() const { return mHead < mEntries.size(); }
+
+    // Absolute time at which the last queued phoneme ends
+    std::uint64_t getTimelineEnd() const { return mTimelineEndUs; }
+
+private:
+    std::vector<Entry> mEntries;
+    size_t mHead = 0;
+
+    std::uint64_t mTimelineEndUs = 0;
+    std::uint64_t mLocalAnchorUs = 0;
+    std::uint64_t mProducerAnchorUs = 0;
+
+    std::uint64_t mAudioClockUs = 0;
+    std::uint64_t mAudioClockLocalUs = 0;
+    std::uint64_t mAudioProgressUs = 0;
+    std::int64_t mAudioLagUs = 0;
+
+    int mCurrentViseme = -1;
+    int mPreviousViseme = -1;
+    std::uint64_t mCurrentStartUs = 0;
+    std::uint64_t mCurrentEndUs = 0;
+    std::uint64_t mCurrentProducerUs = 0;
+};
+
+#endif // ES_APP_SERVICES_VISEME_SCHEDULER_H
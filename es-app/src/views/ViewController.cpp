@@ -734,12 +734,16 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 	else if (themeHasGamecarouselView && viewPreference.compare("gamecarousel") == 0)
 		selectedViewType = GAMECAROUSEL;
 
+	bool automaticViewType = false;
+
 	if (!forceView && (selectedViewType == AUTOMATIC || allowDetailedDowngrade))
 	{
 		selectedViewType = BASIC;
 
 		if (system->getTheme()->getDefaultView() != "basic")
 		{
+			automaticViewType = true;
+
 			std::vector<FileData*> files = system->getRootFolder()->getFilesRecursive(GAME | FOLDER);
 			for (auto it = files.cbegin(); it != files.cend(); it++)
 			{
@@ -779,6 +783,9 @@ std::shared_ptr<IGameListView> ViewController::getGameListView(SystemData* syste
 			break;
 	}
 
+	if (automaticViewType)
+		view->setAutomaticViewType(selectedViewType == VIDEO ? "video" : selectedViewType == DETAILED ? "detailed" : "basic", !allowDetailedDowngrade && themeHasVideoView);
+
 	if (selectedViewType != GRID)
 	{
 		// GridGameListView theme needs to be loaded before populating.
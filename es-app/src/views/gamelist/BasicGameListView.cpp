@@ -46,18 +46,6 @@ void BasicGameListView::onThemeChanged(const std::shared_ptr<ThemeData>& theme)
 	sortChildren();
 }
 
-void BasicGameListView::onFileChanged(FileData* file, FileChangeType change)
-{
-	if(change == FILE_METADATA_CHANGED)
-	{
-		// might switch to a detailed view
-		ViewController::get()->reloadGameListView(this);
-		return;
-	}
-
-	ISimpleGameListView::onFileChanged(file, change);
-}
-
 void BasicGameListView::populateList(const std::vector<FileData*>& files)
 {
 	updateHeaderLogoAndText();
@@ -90,6 +78,74 @@ void BasicGameListView::populateList(const std::vector<FileData*>& files)
 		onShow();
 }
 
+bool BasicGameListView::updateEntry(FileData* file, const std::vector<FileData*>& files)
+{
+	if (files.size() == 0)
+		return false;
+
+	int offset = (mRoot->getSystem()->getShowParentFolder() && mCursorStack.size()) ? 1 : 0;
+
+	auto objects = mList.getObjects();
+	if ((int)objects.size() < offset)
+		return false;
+
+	// Collections show their own entry of the game
+	FileData* source = file->getSourceFileData();
+
+	int from = -1;
+	for (int i = offset; i < (int)objects.size(); i++)
+	{
+		if (objects[i]->getSourceFileData() == source)
+		{
+			from = i;
+			break;
+		}
+	}
+
+	int to = -1;
+	for (int i = 0; i < (int)files.size(); i++)
+	{
+		if (files[i]->getSourceFileData() == source)
+		{
+			to = i;
+			break;
+		}
+	}
+
+	// Every other entry must stay the same
+	std::vector<FileData*> expected(objects.cbegin() + offset, objects.cend());
+	if (from >= 0)
+		expected.erase(expected.begin() + (from - offset));
+
+	if (to >= 0)
+		expected.insert(expected.begin() + to, files[to]);
+
+	if (expected != files)
+		return false;
+
+	if (from < 0 && to < 0)
+		return true;
+
+	if (to < 0)
+	{
+		mList.remove(objects[from]);
+		return true;
+	}
+
+	GameNameFormatter formatter(mRoot->getSystem());
+	std::string name = formatter.getDisplayName(files[to]);
+
+	if (from < 0)
+		mList.insert(to + offset, name, files[to], files[to]->getType() == FOLDER);
+	else
+	{
+		mList.moveEntry(from, to + offset);
+		mList.setEntryName(to + offset, name);
+	}
+
+	return true;
+}
+
 FileData* BasicGameListView::getCursor()
 {
 	if (mList.size() == 0)
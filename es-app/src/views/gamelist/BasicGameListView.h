@@ -10,9 +10,6 @@ class BasicGameListView : public ISimpleGameListView, public ILongMouseClickEven
 public:
 	BasicGameListView(Window* window, FolderData* root);
 
-	// Called when a FileData* is added, has its metadata changed, or is removed
-	virtual void onFileChanged(FileData* file, FileChangeType change);
-
 	virtual void onThemeChanged(const std::shared_ptr<ThemeData>& theme);
 
 	virtual FileData* getCursor() override;
@@ -40,6 +37,7 @@ protected:
 	virtual std::string getQuickSystemSelectRightButton() override;
 	virtual std::string getQuickSystemSelectLeftButton() override;
 	virtual void populateList(const std::vector<FileData*>& files) override;
+	virtual bool updateEntry(FileData* file, const std::vector<FileData*>& files) override;
 	virtual void remove(FileData* game) override;
 	virtual void addPlaceholder();
 
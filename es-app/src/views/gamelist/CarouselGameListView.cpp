@@ -53,18 +53,6 @@ void CarouselGameListView::updateInfoPanel()
 	mDetails.updateControls(file, isClearing, mList.getCursorIndex() - mList.getLastCursor());
 }
 
-void CarouselGameListView::onFileChanged(FileData* file, FileChangeType change)
-{
-	if(change == FILE_METADATA_CHANGED)
-	{
-		// might switch to a detailed view
-		ViewController::get()->reloadGameListView(this);
-		return;
-	}
-
-	ISimpleGameListView::onFileChanged(file, change);
-}
-
 void CarouselGameListView::populateList(const std::vector<FileData*>& files)
 {
 	updateHeaderLogoAndText();
@@ -11,9 +11,6 @@ class CarouselGameListView : public ISimpleGameListView
 public:
 	CarouselGameListView(Window* window, FolderData* root);
 
-	// Called when a FileData* is added, has its metadata changed, or is removed
-	virtual void onFileChanged(FileData* file, FileChangeType change);
-
 	virtual void onThemeChanged(const std::shared_ptr<ThemeData>& theme);
 
 	virtual FileData* getCursor() override;
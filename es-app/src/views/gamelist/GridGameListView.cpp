@@ -265,18 +265,6 @@ void GridGameListView::remove(FileData *game)
 	ViewController::get()->reloadGameListView(this);
 }
 
-void GridGameListView::onFileChanged(FileData* file, FileChangeType change)
-{
-	if (change == FILE_METADATA_CHANGED)
-	{
-		// might switch to a detailed view
-		ViewController::get()->reloadGameListView(this);
-		return;
-	}
-
-	ISimpleGameListView::onFileChanged(file, change);
-}
-
 void GridGameListView::setCursorIndex(int cursor)
 {
 	mGrid.setCursorIndex(cursor);
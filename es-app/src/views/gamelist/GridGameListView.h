@@ -37,7 +37,6 @@ public:
 	}
 
 	virtual void launch(FileData* game) override;
-	virtual void onFileChanged(FileData* file, FileChangeType change);
 
 	virtual void setThemeName(std::string name);
 	virtual void onShow();
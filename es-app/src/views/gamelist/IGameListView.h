@@ -48,10 +48,17 @@ public:
 
 	virtual void repopulate() = 0;
 
+	// Type of view ("basic", "detailed" or "video") chosen according to the media of the games, empty if it was not.
+	// allowVideo : the video view could be chosen (theme has one, and no downgrade from "detailed")
+	inline const std::string& getAutomaticViewType() const { return mAutomaticViewType; }
+	inline void setAutomaticViewType(const std::string& type, bool allowVideo) { mAutomaticViewType = type; mAutomaticViewAllowsVideo = allowVideo; }
+
 protected:
 	FolderData* mRoot;
 	std::shared_ptr<ThemeData> mTheme;
 	std::string mCustomThemeName;
+	std::string mAutomaticViewType;
+	bool mAutomaticViewAllowsVideo = false;
 };
 
 #endif // ES_APP_VIEWS_GAME_LIST_IGAME_LIST_VIEW_H
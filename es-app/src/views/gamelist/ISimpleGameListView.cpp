@@ -103,14 +103,23 @@ void ISimpleGameListView::onThemeChanged(const std::shared_ptr<ThemeData>& theme
 	}
 }
 
-void ISimpleGameListView::onFileChanged(FileData* /*file*/, FileChangeType /*change*/)
+void ISimpleGameListView::onFileChanged(FileData* file, FileChangeType change)
 {
-	// we could be tricky here to be efficient;
-	// but this shouldn't happen very often so we'll just always repopulate
+	if (change == FILE_METADATA_CHANGED && (file->getType() != GAME || isAutomaticViewTypeOutdated(file)))
+	{
+		// might switch to a detailed view
+		ViewController::get()->reloadGameListView(this);
+		return;
+	}
+
 	FileData* cursor = getCursor();
 	if (!cursor->isPlaceHolder()) 
 	{
-		populateList(cursor->getParent()->getChildrenListToDisplay());
+		// When a single game changed, the folder moves it in the list it keeps and the view only moves its entry
+		auto files = cursor->getParent()->getChildrenListToDisplay();
+		if (change != FILE_METADATA_CHANGED || !updateEntry(file, files))
+			populateList(files);
+
 		setCursor(cursor);
 	}
 	else
@@ -123,6 +132,50 @@ void ISimpleGameListView::onFileChanged(FileData* /*file*/, FileChangeType /*cha
 	}
 }
 
+bool ISimpleGameListView::isAutomaticViewTypeOutdated(FileData* game)
+{
+	if (mAutomaticViewType.empty())
+		return false;
+
+	bool hasVideo = mAutomaticViewAllowsVideo && !game->getVideoPath().empty();
+
+	// Media of the game alone decides when it can only raise the view type
+	if (mAutomaticViewType == "basic")
+		return hasVideo || !game->getThumbnailPath().empty();
+
+	if (mAutomaticViewType == "detailed")
+	{
+		if (hasVideo)
+			return true;
+
+		if (!game->getThumbnailPath().empty())
+			return false;
+	}
+	else if (hasVideo)
+		return false;
+
+	// The game may have been the last one with the media the view was chosen for : same choice as ViewController::getGameListView
+	std::string viewType = "basic";
+
+	for (auto file : mRoot->getFilesRecursive(GAME | FOLDER))
+	{
+		if (mAutomaticViewAllowsVideo && !file->getVideoPath().empty())
+		{
+			viewType = "video";
+			break;
+		}
+		else if (!file->getThumbnailPath().empty())
+		{
+			viewType = "detailed";
+
+			if (!mAutomaticViewAllowsVideo)
+				break;
+		}
+	}
+
+	return viewType != mAutomaticViewType;
+}
+
 void ISimpleGameListView::moveToFolder(FolderData* folder)
 {
 	if (folder == nullptr || folder->getChildren().size() == 0)
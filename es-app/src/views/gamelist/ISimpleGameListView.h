@@ -75,6 +75,12 @@ protected:
 	virtual std::string getQuickSystemSelectRightButton() = 0;
 	virtual std::string getQuickSystemSelectLeftButton() = 0;
 	virtual void populateList(const std::vector<FileData*>& files) = 0;
+
+	// Updates the entry of a game after its metadata changed, 'files' being the new list : returns false if the list must be populated again
+	virtual bool updateEntry(FileData* /*file*/, const std::vector<FileData*>& /*files*/) { return false; }
+
+	// Whether the type of view chosen according to the media of the games may change since the metadata of 'game' changed
+	bool isAutomaticViewTypeOutdated(FileData* game);
 	
 	bool cursorHasSaveStatesEnabled();
 
@@ -12,17 +12,19 @@ int PowerSaver::mWakeupTimeout = -1;
 int PowerSaver::mScreenSaverTimeout = -1;
 PowerSaver::mode PowerSaver::mMode = PowerSaver::DISABLED;
 
-bool PowerSaver::mHasPushedEvent = false;
+std::atomic<bool> PowerSaver::mHasPushedEvent(false);
 int PowerSaver::mPushEventID = -1;
 int PowerSaver::mPauseCounter = 0;
+int PowerSaver::mNextKeyframe = -1;
 
 void PowerSaver::pushRefreshEvent()
 {
-	if (mHasPushedEvent || !mState)
+	if (!mState || mPushEventID == -1)
 		return;
 
-	if (mPushEventID == -1)
-		mPushEventID = SDL_RegisterEvents(1);
+	// One event is enough to leave SDL_WaitEventTimeout, until the main loop resets the flag
+	if (mHasPushedEvent.exchange(true))
+		return;
 
 	SDL_Event ev;
 	ev.type = mPushEventID;
@@ -36,16 +38,34 @@ void PowerSaver::resetRefreshEvent()
 
 void PowerSaver::init()
 {
+	if (mPushEventID == -1)
+		mPushEventID = SDL_RegisterEvents(1);
+
 	setState(true);
 	updateMode();
 }
 
 int PowerSaver::getTimeout()
 {
-	 if (mMode == INSTANT || mMode == ENHANCED)
-		 return mRunningScreenSaver ? mWakeupTimeout : mScreenSaverTimeout;
+	int timeout = 40; // 1000;
+
+	if (mMode == INSTANT || mMode == ENHANCED)
+		timeout = mRunningScreenSaver ? mWakeupTimeout : mScreenSaverTimeout;
 
-	 return 40; // 1000;
+	// Sleep until the next keyframe of a low rate animation, but not past a screensaver wake up
+	if (mNextKeyframe >= 0)
+	{
+		int keyframe = Math::max(0, mNextKeyframe - (int)SDL_GetTicks());
+		if (mMode == DEFAULT || timeout < 0 || keyframe < timeout)
+			return keyframe;
+	}
+
+	return timeout;
+}
+
+void PowerSaver::setNextKeyframe(int delayMs)
+{
+	mNextKeyframe = delayMs < 0 ? -1 : (int)SDL_GetTicks() + delayMs;
 }
 
 void PowerSaver::loadWakeupTime()
@@ -2,6 +2,8 @@
 #ifndef ES_CORE_POWER_SAVER_H
 #define ES_CORE_POWER_SAVER_H
 
+#include <atomic>
+
 class PowerSaver
 {
 public:
@@ -58,6 +60,11 @@ public:
 	}
 
 
+	// Set by screens which only animate at a low rate (idle AI face...) : the main loop waits for events until
+	// their next keyframe instead of rendering at full rate. 'delayMs' is counted from now, -1 clears it.
+	static void setNextKeyframe(int delayMs);
+	static bool hasKeyframe() { return mNextKeyframe >= 0; }
+
 	// This is used by ScreenSaver to let PS know when to switch to SS timeouts
 	static void runningScreenSaver(bool state);
 	static bool isScreenSaverActive();
@@ -65,7 +72,8 @@ public:
 private:
 	static void setState(bool state);
 
-	static bool mHasPushedEvent;
+	// pushRefreshEvent can be called from any thread, the event type is registered by init() on the UI thread
+	static std::atomic<bool> mHasPushedEvent;
 	static int  mPushEventID;
 
 	static bool mState;
@@ -79,6 +87,7 @@ private:
 
 
 	static int mPauseCounter;
+	static int mNextKeyframe;
 };
 
 #endif // ES_CORE_POWER_SAVER_H
@@ -1228,8 +1228,10 @@ void Window::postToUiThread(const std::function<void()>& func, void* data)
 	{
 		mSleeping = false;
 		mTimeSinceLastInput = 0;
-		PowerSaver::pushRefreshEvent();
 	}
+
+	// The main loop may be waiting for events (PowerSaver) : run the function now rather than at the next timeout
+	PowerSaver::pushRefreshEvent();
 }
 
 void Window::processPostedFunctions()
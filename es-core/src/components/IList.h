@@ -216,6 +216,33 @@ public:
 		mEntries.push_back(e);
 	}
 
+	// inserts before the entry at index, the cursor stays on the same entry
+	void insert(int index, const Entry& e)
+	{
+		mEntries.insert(mEntries.begin() + index, e);
+
+		if (mEntries.size() > 1 && index <= mCursor)
+			mCursor++;
+	}
+
+	// moves the entry at index 'from' so it ends at index 'to', the cursor stays on the same entry
+	void moveEntry(int from, int to)
+	{
+		if (from == to)
+			return;
+
+		Entry entry = mEntries[from];
+		mEntries.erase(mEntries.begin() + from);
+		mEntries.insert(mEntries.begin() + to, entry);
+
+		if (mCursor == from)
+			mCursor = to;
+		else if (from < mCursor && to >= mCursor)
+			mCursor--;
+		else if (from > mCursor && to <= mCursor)
+			mCursor++;
+	}
+
 	bool remove(const UserData& obj)
 	{
 		for(auto it = mEntries.cbegin(); it != mEntries.cend(); it++)
@@ -0,0 +1,303 @@
+#include "components/StreamingTextComponent.h"
+
+#include "math/Misc.h"
+#include "renderers/Renderer.h"
+#include "utils/StringUtil.h"
+
+#define DEFAULT_MAX_LINES 200
+
+// Length of 'text' without a trailing UTF-8 sequence which is not complete yet
+static size_t completeUtf8Length(const std::string& text)
+{
+	size_t len = text.length();
+	size_t start = len;
+
+	while (start > 0 && len - start < 4)
+	{
+		unsigned char c = (unsigned char)text[start - 1];
+		start--;
+
+		if ((c & 0xC0) == 0x80)
+			continue; // continuation byte
+
+		size_t expected = (c & 0x80) == 0 ? 1 : (c & 0xE0) == 0xC0 ? 2 : (c & 0xF0) == 0xE0 ? 3 : 4;
+		return len - start >= expected ? len : start;
+	}
+
+	return len;
+}
+
+// Scripts written without spaces between words : a line can break after any of their characters
+static bool isBreakableCharacter(unsigned int unicode)
+{
+	return (unicode >= 0x2E80 && unicode <= 0x9FFF) ||	// CJK radicals & punctuation, kana, CJK ideographs
+		(unicode >= 0xF900 && unicode <= 0xFAFF) ||		// CJK compatibility ideographs
+		(unicode >= 0xFF00 && unicode <= 0xFFEF) ||		// Fullwidth forms
+		(unicode >= 0x20000 && unicode <= 0x2FFFF);		// CJK ideographs extensions
+}
+
+StreamingTextComponent::StreamingTextComponent(Window* window, const std::shared_ptr<Font>& font, unsigned int color) : GuiComponent(window),
+	mFont(font != nullptr ? font : Font::get(FONT_SIZE_SMALL)), mColor(color), mBackgroundColor(0), mLineSpacing(1.5f), mMaxLines(DEFAULT_MAX_LINES),
+	mSpacePending(false), mWordWrapped(false)
+{
+
+}
+
+StreamingTextComponent::~StreamingTextComponent()
+{
+
+}
+
+void StreamingTextComponent::append(const std::string& text)
+{
+	for (auto c : text)
+	{
+		if (c == '\n')
+		{
+			commitWord();
+			newLine();
+			mSpacePending = false;
+		}
+		else if (c == ' ' || c == '\t')
+		{
+			commitWord();
+			mSpacePending = !mLines.empty() && !mLines.back().text.empty();
+		}
+		else if (c != '\r')
+		{
+			mWord += c;
+
+			if (completeUtf8Length(mWord) == mWord.length())
+				breakWord();
+		}
+	}
+
+	updateWordCache();
+}
+
+// Called when the last character of the word is complete : the word being received never gets wider than a line
+void StreamingTextComponent::breakWord()
+{
+	size_t start = Utils::String::prevCursor(mWord, mWord.length());
+	size_t cursor = start;
+
+	if (isBreakableCharacter(Utils::String::chars2Unicode(mWord, cursor)))
+	{
+		commitWord();
+		return;
+	}
+
+	if (mSize.x() <= 0 || start == 0 || mFont->sizeText(mWord, mLineSpacing).x() <= mSize.x())
+		return;
+
+	// The word doesn't fit on a line : the last character starts the next one
+	std::string last = mWord.substr(start);
+	mWord.resize(start);
+	commitWord();
+	mWord = last;
+}
+
+void StreamingTextComponent::clear()
+{
+	mLines.clear();
+	mWord.clear();
+	mWordCache.reset();
+	mSpacePending = false;
+	mWordWrapped = false;
+}
+
+void StreamingTextComponent::newLine(bool wrapped)
+{
+	Line line;
+	line.cache = std::unique_ptr<TextCache>(new TextCache());
+	line.cache->metrics.size = Vector2f(0, 0);
+	line.width = 0;
+	line.wrapped = wrapped;
+	line.joined = false;
+	mLines.push_back(std::move(line));
+
+	// Bounded scrollback
+	while (mLines.size() > mMaxLines)
+		mLines.pop_front();
+}
+
+void StreamingTextComponent::commitWord()
+{
+	if (mWord.empty())
+		return;
+
+	if (mLines.empty())
+		newLine();
+
+	Line* line = &mLines.back();
+
+	std::string piece = mSpacePending && !line->text.empty() ? " " + mWord : mWord;
+
+	if (mSize.x() > 0 && !line->text.empty() && line->width + mFont->sizeText(piece, mLineSpacing).x() > mSize.x())
+	{
+		newLine(true);
+		line = &mLines.back();
+		line->joined = !mSpacePending;
+		piece = mWord;
+	}
+
+	// Only the glyphs of the new word are laid out
+	line->width = mFont->appendToTextCache(line->cache.get(), piece, line->width, 0, mColor, mLineSpacing);
+	line->text += piece;
+
+	mWord.clear();
+	mSpacePending = false;
+}
+
+void StreamingTextComponent::updateWordCache()
+{
+	mWordWrapped = false;
+
+	std::string word = mWord.substr(0, completeUtf8Length(mWord));
+	if (word.empty())
+	{
+		mWordCache.reset();
+		return;
+	}
+
+	float x = 0;
+
+	if (!mLines.empty() && !mLines.back().text.empty())
+	{
+		if (mSpacePending)
+			word = " " + word;
+
+		x = mLines.back().width;
+
+		if (mSize.x() > 0 && x + mFont->sizeText(word, mLineSpacing).x() > mSize.x())
+		{
+			word = mWord.substr(0, completeUtf8Length(mWord));
+			x = 0;
+			mWordWrapped = true;
+		}
+	}
+
+	// The word being received is short : rebuilding its cache is cheap
+	mWordCache = std::unique_ptr<TextCache>(new TextCache());
+	mWordCache->metrics.size = Vector2f(0, 0);
+	mFont->appendToTextCache(mWordCache.get(), word, x, 0, mColor, mLineSpacing);
+}
+
+void StreamingTextComponent::relayout()
+{
+	std::string text;
+
+	for (auto& line : mLines)
+	{
+		if (&line != &mLines.front())
+			text += line.joined ? "" : line.wrapped ? " " : "\n";
+
+		text += line.text;
+	}
+
+	if (mSpacePending)
+		text += " ";
+
+	text += mWord;
+
+	clear();
+	append(text);
+}
+
+void StreamingTextComponent::setFont(const std::shared_ptr<Font>& font)
+{
+	if (font == nullptr || mFont == font)
+		return;
+
+	mFont = font;
+	relayout();
+}
+
+void StreamingTextComponent::setColor(unsigned int color)
+{
+	if (mColor == color)
+		return;
+
+	mColor = color;
+
+	for (auto& line : mLines)
+		line.cache->setColor(color);
+
+	if (mWordCache != nullptr)
+		mWordCache->setColor(color);
+}
+
+void StreamingTextComponent::setLineSpacing(float lineSpacing)
+{
+	if (mLineSpacing == lineSpacing)
+		return;
+
+	mLineSpacing = lineSpacing;
+	relayout();
+}
+
+void StreamingTextComponent::setMaxLines(size_t maxLines)
+{
+	mMaxLines = maxLines > 0 ? maxLines : 1;
+
+	while (mLines.size() > mMaxLines)
+		mLines.pop_front();
+}
+
+void StreamingTextComponent::onSizeChanged()
+{
+	GuiComponent::onSizeChanged();
+	relayout();
+}
+
+void StreamingTextComponent::render(const Transform4x4f& parentTrans)
+{
+	if (!isVisible())
+		return;
+
+	Transform4x4f trans = parentTrans * getTransform();
+
+	auto rect = Renderer::getScreenRect(trans, mSize);
+	if (!Renderer::isVisibleOnScreen(rect))
+		return;
+
+	if (mBackgroundColor & 0xFF)
+	{
+		Renderer::setMatrix(trans);
+		Renderer::drawRect(0.0f, 0.0f, mSize.x(), mSize.y(), mBackgroundColor, mBackgroundColor);
+	}
+
+	if (!mLines.empty() || mWordCache != nullptr)
+	{
+		Renderer::pushClipRect(rect);
+
+		// Stay scrolled to the last line : only the lines which fit are drawn
+		float lineHeight = mFont->getHeight(mLineSpacing);
+
+		size_t rows = mLines.empty() ? 1 : mLines.size() + (mWordWrapped ? 1 : 0);
+		size_t visibleRows = lineHeight > 0 && mSize.y() > 0 ? (size_t)Math::max(1, (int)(mSize.y() / lineHeight)) : rows;
+		size_t firstRow = rows > visibleRows ? rows - visibleRows : 0;
+
+		for (size_t i = firstRow; i < mLines.size(); i++)
+		{
+			Transform4x4f lineTrans = trans;
+			lineTrans.translate(Vector3f(0, (i - firstRow) * lineHeight, 0));
+			Renderer::setMatrix(lineTrans);
+			mFont->renderTextCache(mLines[i].cache.get());
+		}
+
+		if (mWordCache != nullptr)
+		{
+			size_t row = mLines.empty() ? 0 : mLines.size() - 1 + (mWordWrapped ? 1 : 0);
+
+			Transform4x4f lineTrans = trans;
+			lineTrans.translate(Vector3f(0, (row - firstRow) * lineHeight, 0));
+			Renderer::setMatrix(lineTrans);
+			mFont->renderTextCache(mWordCache.get());
+		}
+
+		Renderer::popClipRect();
+	}
+
+	GuiComponent::renderChildren(trans);
+}
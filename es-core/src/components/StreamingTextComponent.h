@@ -0,0 +1,71 @@
+#pragma once
+#ifndef ES_CORE_COMPONENTS_STREAMING_TEXT_COMPONENT_H
+#define ES_CORE_COMPONENTS_STREAMING_TEXT_COMPONENT_H
+
+#include "GuiComponent.h"
+#include "resources/Font.h"
+#include <deque>
+#include <memory>
+#include <string>
+
+class TextCache;
+
+// Append-only, word wrapped text which stays scrolled to its last line (LLM token streams, logs...).
+// Each line owns its TextCache : appending a word adds its glyphs to the cache of the last line, nothing laid out
+// before is ever rebuilt. The word still being received has its own small cache until a space or a line break ends it.
+// Text without spaces (CJK) is committed a character at a time, and words wider than a line are broken.
+// Only the last 'maxLines' lines are kept.
+class StreamingTextComponent : public GuiComponent
+{
+public:
+	StreamingTextComponent(Window* window, const std::shared_ptr<Font>& font = nullptr, unsigned int color = 0x000000FF);
+	~StreamingTextComponent();
+
+	// 'text' can stop in the middle of a word (or of an UTF-8 sequence). '\n' starts a new line.
+	void append(const std::string& text);
+	void clear();
+
+	void setFont(const std::shared_ptr<Font>& font);
+	void setColor(unsigned int color);
+	void setBackgroundColor(unsigned int color) { mBackgroundColor = color; }
+	void setLineSpacing(float lineSpacing);
+	void setMaxLines(size_t maxLines);
+
+	bool empty() const { return mLines.empty() && mWord.empty(); }
+
+	void render(const Transform4x4f& parentTrans) override;
+	void onSizeChanged() override;
+
+private:
+	struct Line
+	{
+		std::string text;
+		std::unique_ptr<TextCache> cache;
+		float width;
+		bool wrapped; // started by word wrapping rather than by '\n'
+		bool joined;  // wrapped without a space : CJK text or broken word
+	};
+
+	void newLine(bool wrapped = false);
+	void commitWord();
+	void breakWord();
+	void updateWordCache();
+	void relayout();
+
+	std::shared_ptr<Font> mFont;
+	unsigned int mColor;
+	unsigned int mBackgroundColor;
+	float mLineSpacing;
+	size_t mMaxLines;
+
+	std::deque<Line> mLines;
+
+	// Word being received, and whether a space separates it from the end of the last line
+	std::string mWord;
+	bool mSpacePending;
+
+	std::unique_ptr<TextCache> mWordCache;
+	bool mWordWrapped;
+};
+
+#endif // ES_CORE_COMPONENTS_STREAMING_TEXT_COMPONENT_H
@@ -72,6 +72,16 @@ public:
 	void setOpacity(unsigned char opacity) override;
 
 	void add(const std::string& name, const T& obj, unsigned int colorId);
+	void insert(int index, const std::string& name, const T& obj, unsigned int colorId);
+
+	inline void setEntryName(int index, const std::string& name)
+	{
+		if (mEntries[index].name == name)
+			return;
+
+		mEntries[index].name = name;
+		mEntries[index].data.textCache.reset();
+	}
 
 	enum Alignment
 	{
@@ -579,6 +589,18 @@ void TextListComponent<T>::add(const std::string& name, const T& obj, unsigned i
 	static_cast<IList< TextListData, T >*>(this)->add(entry);
 }
 
+template <typename T>
+void TextListComponent<T>::insert(int index, const std::string& name, const T& obj, unsigned int color)
+{
+	assert(color < COLOR_ID_COUNT);
+
+	typename IList<TextListData, T>::Entry entry;
+	entry.name = name;
+	entry.object = obj;
+	entry.data.colorId = color;
+	static_cast<IList< TextListData, T >*>(this)->insert(index, entry);
+}
+
 template <typename T>
 void TextListComponent<T>::onSizeChanged()
 {
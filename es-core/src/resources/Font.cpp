@@ -1080,6 +1080,79 @@ TextCache* Font::buildTextCache(const std::string& text, float offsetX, float of
 	return buildTextCache(text, Vector2f(offsetX, offsetY), color, 0.0f);
 }
 
+float Font::appendToTextCache(TextCache* cache, const std::string& text, float x, float lineTop, unsigned int color, float lineSpacing)
+{
+	if (cache == nullptr)
+		return x;
+
+	auto glyph = getGlyph('S');
+	float yTop = glyph ? glyph->bearing.y() : 35;
+	float yBot = getHeight(lineSpacing);
+	float y = lineTop + (yBot + yTop) / 2.0f;
+
+	const unsigned int convertedColor = Renderer::convertColor(color);
+
+	size_t cursor = 0;
+	while (cursor < text.length())
+	{
+		unsigned int character = Utils::String::chars2Unicode(text, cursor); // also advances cursor
+		if (character == 0 || character == '\r' || character == '\n')
+			continue;
+
+		if (character == '\t')
+			character = ' ';
+
+		glyph = getGlyph(character);
+		if (glyph == NULL)
+			continue;
+
+		// Glyphs are grouped by font texture, like buildTextCache does
+		TextCache::VertexList* list = nullptr;
+		for (auto& vertList : cache->vertexLists)
+		{
+			if (vertList.textureIdPtr == &glyph->texture->textureId)
+			{
+				list = &vertList;
+				break;
+			}
+		}
+
+		if (list == nullptr)
+		{
+			cache->vertexLists.push_back(TextCache::VertexList());
+			list = &cache->vertexLists.back();
+			list->textureIdPtr = &glyph->texture->textureId;
+		}
+
+		std::vector<Renderer::Vertex>& verts = list->verts;
+		size_t oldVertSize = verts.size();
+		verts.resize(oldVertSize + 6);
+		Renderer::Vertex* vertices = verts.data() + oldVertSize;
+
+		const float glyphStartX = x + glyph->bearing.x();
+
+		vertices[1] = { { glyphStartX                        , y - glyph->bearing.y()                         }, { glyph->texPos.x(),                      glyph->texPos.y()                      }, convertedColor };
+		vertices[2] = { { glyphStartX                        , y - glyph->bearing.y() + (glyph->glyphSize.y()) }, { glyph->texPos.x(),                      glyph->texPos.y() + glyph->texSize.y() }, convertedColor };
+		vertices[3] = { { glyphStartX + glyph->glyphSize.x() , y - glyph->bearing.y()                         }, { glyph->texPos.x() + glyph->texSize.x(), glyph->texPos.y()                      }, convertedColor };
+		vertices[4] = { { glyphStartX + glyph->glyphSize.x() , y - glyph->bearing.y() + (glyph->glyphSize.y()) }, { glyph->texPos.x() + glyph->texSize.x(), glyph->texPos.y() + glyph->texSize.y() }, convertedColor };
+
+		for (int i = 1; i < 5; ++i)
+			vertices[i].pos.round();
+
+		// make duplicates of first and last vertex so this can be rendered as a triangle strip
+		vertices[0] = vertices[1];
+		vertices[5] = vertices[4];
+
+		x += glyph->advance.x();
+	}
+
+	cache->metrics.size = Vector2f(Math::max(cache->metrics.size.x(), x), Math::max(cache->metrics.size.y(), lineTop + yBot));
+
+	clearFaceCache();
+
+	return x;
+}
+
 void TextCache::setColors(unsigned int color, unsigned int extraColor)
 {
 	const unsigned int convertedColor = Renderer::convertColor(color);
@@ -53,6 +53,10 @@ public:
 	TextCache* buildTextCache(const std::string& text, float offsetX, float offsetY, unsigned int color);
 	TextCache* buildTextCache(const std::string& text, Vector2f offset, unsigned int color, float xLen, Alignment alignment = ALIGN_LEFT, float lineSpacing = 1.5f);
 	
+	// Adds the glyphs of a single line of text at the end of an existing cache, starting at 'x' on the line whose top is 'lineTop'.
+	// Nothing already in the cache is laid out again. Returns the x position after the text.
+	float appendToTextCache(TextCache* cache, const std::string& text, float x, float lineTop, unsigned int color, float lineSpacing = 1.5f);
+
 	void renderTextCache(TextCache* cache, bool verticesChanged = true);
 	void renderTextCacheEx(TextCache* cache, const Transform4x4f& parentTrans, unsigned int mGlowSize, unsigned int mGlowColor, Vector2f& mGlowOffset, unsigned char mOpacity = 255);
 
@@ -0,0 +1,64 @@
+#pragma once
+#ifndef ES_CORE_UTILS_SPSC_RING_H
+#define ES_CORE_UTILS_SPSC_RING_H
+
+#include <atomic>
+#include <cstddef>
+
+namespace Utils
+{
+	// Fixed size, lock-free ring for exactly one producer thread and one consumer thread.
+	// Storage is preallocated : push and pop never allocate.
+	template<typename T, size_t N>
+	class SpscRing
+	{
+		static_assert(N >= 2 && (N & (N - 1)) == 0, "SpscRing size must be a power of two");
+
+	public:
+		SpscRing() : mHead(0), mTail(0) { }
+
+		// Producer side. Returns false if the ring is full.
+		bool push(const T& item)
+		{
+			size_t tail = mTail.load(std::memory_order_relaxed);
+			if (tail - mHead.load(std::memory_order_acquire) >= N)
+				return false;
+
+			mItems[tail & (N - 1)] = item;
+			mTail.store(tail + 1, std::memory_order_release);
+			return true;
+		}
+
+		// Consumer side. Copies up to 'max' items into 'out', returns the number of items copied.
+		size_t pop(T* out, size_t max)
+		{
+			size_t head = mHead.load(std::memory_order_relaxed);
+			size_t count = mTail.load(std::memory_order_acquire) - head;
+			if (count > max)
+				count = max;
+
+			for (size_t i = 0; i < count; i++)
+				out[i] = mItems[(head + i) & (N - 1)];
+
+			mHead.store(head + count, std::memory_order_release);
+			return count;
+		}
+
+		// Consumer side
+		void clear() { mHead.store(mTail.load(std::memory_order_acquire), std::memory_order_release); }
+
+		size_t size() const { return mTail.load(std::memory_order_acquire) - mHead.load(std::memory_order_acquire); }
+		bool empty() const { return size() == 0; }
+
+		static constexpr size_t capacity() { return N; }
+
+	private:
+		// Keep producer and consumer indexes on separate cache lines
+		std::atomic<size_t> mHead;
+		char mPadding[64 - sizeof(std::atomic<size_t>)];
+		std::atomic<size_t> mTail;
+		T mItems[N];
+	};
+}
+
+#endif // ES_CORE_UTILS_SPSC_RING_H
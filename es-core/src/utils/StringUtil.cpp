@@ -707,6 +707,36 @@ namespace Utils
 			}
 		}
 
+		std::string getIgnoreCaseSortKey(const std::string& _string)
+		{
+			// Characters folded the same way as compareIgnoreCase : utf8 keeps the order of the code points
+			std::string result;
+			result.reserve(_string.size());
+
+			size_t cursor = 0;
+			while (cursor < _string.size())
+			{
+				char c = _string[cursor];
+				if ((c & 0x80) == 0)
+				{
+					if (c == 0)
+						break;
+
+					result += (c >= 'a' && c <= 'z') ? (char)(c - 0x20) : c;
+					cursor++;
+					continue;
+				}
+
+				unsigned int unicode = toupperUnicode(chars2Unicode(_string, cursor));
+				if (unicode == 0)
+					break;
+
+				result += unicode2Chars(unicode);
+			}
+
+			return result;
+		}
+
 		bool containsIgnoreCase(const std::string & _string, const std::string & _what)
 		{
 			auto it = std::search(
@@ -719,11 +749,21 @@ namespace Utils
 		}
 		
 		bool containsIgnoreCasePinyin(const std::string & _string, const std::string & _what)
+		{
+			auto initials = getPinyinInitials(_string);
+			return !initials.empty() && containsPinyin(initials, _what);
+		}
+
+		std::vector<const char*> getPinyinInitials(const std::string & _string)
 		{
 			std::vector<const char*> vpinyin;
+
+			// all chars < 0x80
+			if (std::find_if(_string.cbegin(), _string.cend(), [](char ch) { return (ch & 0x80) != 0; }) == _string.cend())
+				return vpinyin;
+
 			size_t len = _string.size();
 			size_t idx = 0;
-			bool ret = false;
 
 			vpinyin.reserve(len);
 			while(idx < len) {
@@ -731,7 +771,6 @@ namespace Utils
 				if (code < 0x80) {
 					vpinyin.push_back( s_tblpinyin[_string[idx-1]] );
 				} else {
-					ret = true;
 					auto it = s_mapPinyin.find(code);
 					if (it != s_mapPinyin.end()) {
 						vpinyin.push_back(it->second);
@@ -740,10 +779,14 @@ namespace Utils
 					}
 				}
 			}
-			if (!ret) return false; // all chars < 0x80
 
+			return vpinyin;
+		}
+
+		bool containsPinyin(const std::vector<const char*>& _initials, const std::string & _what)
+		{
 			auto it = std::search(
-				vpinyin.begin(), vpinyin.end(),
+				_initials.begin(), _initials.end(),
 				_what.begin(), _what.end(),
 				[](const char *ptr, char ch2) {
 				    if (!ptr) return false;
@@ -754,7 +797,7 @@ namespace Utils
 					}
 				}
 			);
-			return (it != vpinyin.end());
+			return (it != _initials.end());
 		}
 
 		std::string proper(const std::string& _string)
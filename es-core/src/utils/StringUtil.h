@@ -36,10 +36,13 @@ namespace Utils
 
 		std::string join(const std::vector<std::string>& items, std::string separator);
 		int			compareIgnoreCase(const std::string& name1, const std::string& name2);
+		std::string getIgnoreCaseSortKey(const std::string& _string); // same order as compareIgnoreCase, with std::string::compare
 		std::string proper(const std::string& _string);
 		std::string removeHtmlTags(const std::string& html);
 		bool        containsIgnoreCase(const std::string & _string, const std::string & _what);
 		bool        containsIgnoreCasePinyin(const std::string & _string, const std::string & _what);
+		std::vector<const char*> getPinyinInitials(const std::string & _string); // empty if the string has no unicode character
+		bool        containsPinyin(const std::vector<const char*>& _initials, const std::string & _what);
 		bool		startsWithIgnoreCase(const std::string& name1, const std::string& name2);
 
 		int			toInteger(const std::string& string);
@@ -28,12 +28,12 @@ namespace Utils
 
 			while (mRunning)
 			{
-				_mutex.lock();
+				std::unique_lock<std::mutex> lock(_mutex);
 				if (!mWorkQueue.empty())
 				{
 					auto work = mWorkQueue.front();
 					mWorkQueue.pop();
-					_mutex.unlock();
+					lock.unlock();
 
 					try
 					{
@@ -41,18 +41,20 @@ namespace Utils
 					}
 					catch (...) {}
 					
-					mNumWork--;
+					if (--mNumWork == 0)
+					{
+						std::lock_guard<std::mutex> doneLock(_mutex);
+						mWorkDone.notify_all();
+					}
 				}
 				else
 				{
-					_mutex.unlock();
-
 					// Extra code : Exit finished threads
 					if (mWaiting)
 						return;
 
-					std::this_thread::yield();
-					std::this_thread::sleep_for(std::chrono::milliseconds(1));
+					// Woken up when work is queued, the timeout checks mRunning & mWaiting again
+					mWorkQueued.wait_for(lock, std::chrono::milliseconds(1));
 				}
 			}
 		};
@@ -78,6 +80,8 @@ namespace Utils
 		mWorkQueue.push(work);
 		mNumWork++;
 		_mutex.unlock();
+
+		mWorkQueued.notify_one();
 	}
 
 	void ThreadPool::wait()
@@ -106,6 +110,15 @@ namespace Utils
 		}
 	}
 
+	void ThreadPool::waitAll()
+	{
+		if (!mRunning)
+			start();
+
+		std::unique_lock<std::mutex> lock(_mutex);
+		mWorkDone.wait(lock, [this] { return mNumWork.load() == 0; });
+	}
+
 	void ThreadPool::stop()
 	{
 		_mutex.lock();
@@ -3,6 +3,7 @@
 
 #include <thread>
 #include <mutex>
+#include <condition_variable>
 #include <queue>
 #include <atomic>
 #include <functional>
@@ -21,6 +22,8 @@ namespace Utils
 		void queueWorkItem(work_function work);
 		void wait();
 		void wait(work_function work, int delay = 50);
+		// Like wait(), for work items which queue other work items : idle threads stay available until everything is done
+		void waitAll();
 		void cancel() { mRunning = false; }
 		void stop();
 
@@ -32,6 +35,8 @@ namespace Utils
 		std::queue<work_function> mWorkQueue;
 		std::atomic<size_t> mNumWork;
 		std::mutex _mutex;
+		std::condition_variable mWorkQueued;
+		std::condition_variable mWorkDone;
 		std::vector<std::thread> mThreads;
 		int mThreadByCore;
 
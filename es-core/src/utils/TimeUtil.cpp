@@ -363,7 +363,13 @@ namespace Utils
 		std::string timeToString(const time_t& _time, const std::string& _format)
 		{
 			const char* f = _format.c_str();
-			const tm timeStruct = *localtime(&_time);
+
+			tm timeStruct;
+#if WIN32
+			localtime_s(&timeStruct, &_time);
+#else
+			localtime_r(&_time, &timeStruct);
+#endif
 			char buf[256] = { '\0' };
 			char* s = buf;
 
@@ -0,0 +1,81 @@
+#if defined(VERTEX)
+
+#if __VERSION__ >= 130
+#define COMPAT_VARYING out
+#define COMPAT_ATTRIBUTE in
+#define COMPAT_TEXTURE texture
+#else
+#define COMPAT_VARYING varying 
+#define COMPAT_ATTRIBUTE attribute 
+#define COMPAT_TEXTURE texture2D
+#endif
+
+#ifdef GL_ES
+#define COMPAT_PRECISION mediump
+#else
+#define COMPAT_PRECISION
+#endif
+
+uniform   mat4 MVPMatrix;
+COMPAT_ATTRIBUTE vec2 VertexCoord;
+COMPAT_ATTRIBUTE vec2 TexCoord;
+COMPAT_ATTRIBUTE vec4 COLOR;
+COMPAT_VARYING   vec2 v_tex;
+COMPAT_VARYING   vec4 v_col;
+void main(void)                                    
+{                                                  
+	gl_Position = MVPMatrix * vec4(VertexCoord.xy, 0.0, 1.0);
+	v_tex       = TexCoord;                           
+	v_col       = COLOR;                           
+}
+
+#elif defined(FRAGMENT)
+
+#if __VERSION__ >= 130
+#define COMPAT_VARYING in
+#define COMPAT_TEXTURE texture
+out vec4 FragColor;
+#else
+#define COMPAT_VARYING varying
+#define FragColor gl_FragColor
+#define COMPAT_TEXTURE texture2D
+#endif
+
+#ifdef GL_ES
+#ifdef GL_FRAGMENT_PRECISION_HIGH
+precision highp float;
+#else
+precision mediump float;
+#endif
+#define COMPAT_PRECISION mediump
+#else
+#define COMPAT_PRECISION
+#endif
+
+// Crossfade between two tiles of the same atlas (VisemeAtlasComponent)
+// TexCoord addresses the current tile, previousOffset is the uv offset from the current tile to the previous one.
+// blend is the weight of the current tile : 0 shows the previous tile, 1 the current one.
+
+COMPAT_VARYING   vec4      v_col;
+COMPAT_VARYING   vec2      v_tex;
+uniform   sampler2D u_tex;
+uniform   COMPAT_PRECISION float saturation;
+uniform   COMPAT_PRECISION vec2 previousOffset;
+uniform   COMPAT_PRECISION float blend;
+
+void main(void)                                    
+{                                                  
+	vec4 current = COMPAT_TEXTURE(u_tex, v_tex);
+	vec4 previous = COMPAT_TEXTURE(u_tex, v_tex + previousOffset);
+
+	vec4 clr = mix(previous, current, clamp(blend, 0.0, 1.0)) * v_col;
+
+	if (saturation != 1.0) {
+		vec3 gray = vec3(dot(clr.rgb, vec3(0.34, 0.55, 0.11)));
+		vec3 mixed = mix(gray, clr.rgb, saturation);
+		clr = vec4(mixed, clr.a);
+	}
+
+	FragColor = clr;
+}
+#endif